@@ -47,7 +47,8 @@
 // push button of rotary encoder
 #define ROTARY_SW 34
 
-// pins for stepper motor actuation
+// pins for stepper motor actuation, one per stepper
+// the number of pins listed here must match STEPPER_CHANNELS in stepper.hpp
 #define MTR_STEPS 4, 32, 33, 25
 
 // pin for UART transfer of MIDI input data
@@ -0,0 +1,92 @@
+#ifndef MIDI_BYTESOURCE_HPP
+#define MIDI_BYTESOURCE_HPP
+#include "SdFat.h"
+#include "globals.hpp"
+#include <queue>
+#include <vector>
+
+// this is the number of bytes our file backed byte source will read
+// from our SD card at once. 512 bytes matches the sector size of our card
+// so that every refill costs us a single sector read
+#define MIDI_BLOCK_SIZE 512
+
+// this class describes anything our midi parser can read bytes from
+// our parser only ever needs to look at the next byte, consume it,
+// and know how many bytes are left, so that is all we require here
+class midiByteSource {
+  public:
+  virtual ~midiByteSource() {}
+
+  // returns the number of bytes that have not yet been consumed
+  virtual uint32_t available(void) = 0;
+
+  // returns the next byte without consuming it
+  // returns 0 if there are no bytes left
+  virtual uint8_t peek(void) = 0;
+
+  // returns the next byte, consuming it in the process
+  // returns 0 if there are no bytes left
+  virtual uint8_t read(void) = 0;
+};
+
+// this byte source holds the entirety of our midi file in memory
+// it is the simplest option, but costs us the size of our file
+// plus the overhead of our queue's allocations
+class queueByteSource : public midiByteSource {
+  // the contents of our midi file, waiting to be parsed
+  std::queue<uint8_t> byteArray;
+
+  public:
+  // reads the remainder of the file passed in to this function
+  // into our byteArray, one byte at a time
+  void loadFile(FsFile& file);
+
+  uint32_t available(void) override;
+  uint8_t peek(void) override;
+  uint8_t read(void) override;
+};
+
+// this byte source streams our midi file directly off of our SD card
+// only a single block of the file is held in memory at any time;
+// once every byte in our block has been consumed, the next block is read in
+// several of these may read from different parts of the same file at once,
+// as each keeps track of its own position within the file
+class fileByteSource : public midiByteSource {
+  // the file we are streaming from. this must stay open
+  // for as long as we are reading from this object
+  FsFile* file = NULL;
+
+  // the position in our file that our next block will be read from
+  uint64_t position = 0;
+
+  // the number of bytes in our file that have not yet been read into our block
+  uint32_t unread = 0;
+
+  // the block of our file currently held in memory
+  std::vector<uint8_t> block;
+
+  // the number of valid bytes currently held in our block
+  uint16_t blockLen = 0;
+
+  // the index of the next byte in our block to be consumed
+  uint16_t blockIdx = 0;
+
+  // reads the next block of our file from our SD card
+  // returns false if there was nothing left to read
+  bool refill(void);
+
+  public:
+  // streams the file passed in from its current position to its end
+  // using a block of blockSize bytes
+  fileByteSource(FsFile* file, const uint16_t blockSize = MIDI_BLOCK_SIZE);
+
+  // streams length bytes of the file passed in, starting from the position start
+  // using a block of blockSize bytes
+  fileByteSource(FsFile* file, const uint64_t start, const uint32_t length, const uint16_t blockSize = MIDI_BLOCK_SIZE);
+
+  uint32_t available(void) override;
+  uint8_t peek(void) override;
+  uint8_t read(void) override;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef MIDI_CLOCKSYNC_HPP
+#define MIDI_CLOCKSYNC_HPP
+#include "globals.hpp"
+
+// the system realtime messages a master device uses to drive our playback
+// its clock is sent 24 times per quarter note, and start, continue and stop
+// control whether our song plays along with it
+#define MIDI_CLOCK 0xF8
+#define MIDI_START 0xFA
+#define MIDI_CONTINUE 0xFB
+#define MIDI_STOP 0xFC
+
+// the number of clocks our master sends per quarter note
+#define MIDI_CLOCK_PPQN 24
+
+// if no clock arrives for this many uS, our master is considered to be gone
+// longer than the gap between clocks at 10 beats per minute
+#define MIDI_CLOCK_TIMEOUT 300000
+
+// how strongly each clock corrects our estimate of our master's clock
+// as right shifts of the error between when it arrived and when we expected it
+// our phase takes 1/8th of each error, and our period 1/64th, so that
+// the jitter of a single clock moves the timing of our notes very little
+// while a real change in tempo is still followed within a few beats
+#define MIDI_CLOCK_PHASE_SHIFT 3
+#define MIDI_CLOCK_PERIOD_SHIFT 6
+
+// a clock arriving further than this fraction of a period from when we expected it
+// as a right shift of our period, means our master has jumped to a new tempo
+// our estimate is then started over rather than slowly pulled across
+#define MIDI_CLOCK_JUMP_SHIFT 1
+
+// this class follows the clock of an external master device with a
+// phase locked loop, estimating when each of its clocks falls and how far apart
+// they are. every clock pulls our estimate towards when it actually arrived
+// so that the jitter of our master and our UART is filtered out of our timing
+// while our song follows any change of tempo
+class clockSync {
+  // the time according to esp_timer_get_time() our last clock arrived
+  // as it was measured, and as our loop estimates it should have arrived
+  int64_t lastArrival = 0;
+  int64_t clockTime = 0;
+
+  // our estimate of the time between clocks in 1/256ths of a uS
+  int64_t period = 0;
+
+  // whether a clock has arrived since our estimate was started over
+  // and whether a second has arrived to give us our period
+  bool primed = false;
+  bool locked = false;
+
+  // true between our master sending start or continue and sending stop
+  bool running = false;
+
+  // the number of clocks that have arrived while running since our song started
+  // our song has reached clock position clockCount - 1
+  uint32_t clockCount = 0;
+
+  public:
+  // takes a clock that arrived at the time passed in
+  void clock(const int64_t arrival);
+
+  // takes a start, sending our song back to its beginning
+  // the first clock after it marks the start of our song
+  void start(void);
+
+  // takes a continue, resuming our song from the clock it stopped at
+  void resume(void);
+
+  // takes a stop, pausing our song until our master starts or continues it
+  void stop(void);
+
+  // moves our song to the first clock at or after the tick passed in
+  // used when a song playing at its own tempo begins following our master
+  // division is the number of ticks per quarter note of our song
+  void align(const uint64_t tick, const uint16_t division);
+
+  // forgets our master's tempo, used once its clock has gone quiet
+  void unlock(void);
+
+  // returns true if a clock has arrived within MIDI_CLOCK_TIMEOUT of now
+  bool present(const int64_t now) const;
+
+  // returns true while our master has our song playing
+  bool isRunning(void) const;
+
+  // returns true if the tick passed in falls before our master's next clock
+  // we never play ahead of a clock that hasn't arrived, so that our song
+  // stops where our master does even if its stop never reaches us
+  // division is the number of ticks per quarter note of our song
+  bool reaches(const uint64_t tick, const uint16_t division) const;
+
+  // returns the time according to esp_timer_get_time() at which
+  // the tick passed in falls, as our master's clock is currently estimated
+  int64_t dueTime(const uint64_t tick, const uint16_t division) const;
+
+  // returns our estimate of our master's tempo in uS per quarter note
+  // or 0 if we haven't locked on to its clock
+  uint32_t getTempo(void) const;
+};
+
+#endif
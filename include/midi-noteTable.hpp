@@ -0,0 +1,158 @@
+#ifndef MIDI_NOTETABLE_HPP
+#define MIDI_NOTETABLE_HPP
+#include "globals.hpp"
+#include <array>
+
+// the frequency in mHz our concert pitch note is tuned to
+// every other note is tuned relative to it in equal temperament
+#define MIDI_CONCERT_PITCH 440000
+
+// the midi note number of our concert pitch, A4
+#define MIDI_CONCERT_NOTE 69
+
+// the lowest and highest notes we send to our stepper motors
+// notes outside of this range are moved by whole octaves until they fit
+// so that they keep their pitch, only in a different octave
+// B6 is the highest note our steppers play cleanly
+#define MIDI_NOTE_LOWEST 0
+#define MIDI_NOTE_HIGHEST 95
+
+// the number of notes a midi note number can refer to
+#define MIDI_NOTE_COUNT 128
+
+static_assert(MIDI_NOTE_HIGHEST < MIDI_NOTE_COUNT, "our highest note must be a valid midi note");
+static_assert(MIDI_NOTE_HIGHEST - MIDI_NOTE_LOWEST >= 11, "our range must span a whole octave for every note to fit within it");
+
+namespace midi {
+  // the frequency ratio between neighbouring semitones, the twelfth root of two
+  constexpr double semitoneRatio = 1.05946309435929526456;
+
+  // returns our semitone ratio raised to the power passed in
+  constexpr double semitonePow(const uint8_t semitones) {
+    return (semitones == 0) ? 1.0 : semitoneRatio * semitonePow(semitones - 1);
+  }
+
+  // returns 2 raised to the power passed in, which may be negative
+  // every step is exact, so whole octaves add no error of their own
+  constexpr double octavePow(const int8_t octaves) {
+    return (octaves == 0) ? 1.0 : ((octaves > 0) ? 2.0 * octavePow(octaves - 1) : 0.5 * octavePow(octaves + 1));
+  }
+
+  // returns the frequency in mHz of the note passed in, rounded to the nearest mHz
+  // our distance from our concert pitch is split into whole octaves and
+  // the 0 to 11 semitones left over. 120 is added first so that notes below
+  // our concert pitch still divide down to the octave beneath them
+  constexpr uint32_t exactMilliHz(const uint8_t note) {
+    return (uint32_t)(MIDI_CONCERT_PITCH * octavePow(((note - MIDI_CONCERT_NOTE + 120) / 12) - 10) * semitonePow((note - MIDI_CONCERT_NOTE + 120) % 12) + 0.5);
+  }
+
+  // moves the note passed in by whole octaves until it lies within our range
+  // no note lies beneath a range starting at 0, so only then is that left unchecked
+  constexpr uint8_t foldNote(const uint8_t note) {
+#if MIDI_NOTE_LOWEST > 0
+    return (note > MIDI_NOTE_HIGHEST) ? foldNote(note - 12) : ((note < MIDI_NOTE_LOWEST) ? foldNote(note + 12) : note);
+#else
+    return (note > MIDI_NOTE_HIGHEST) ? foldNote(note - 12) : note;
+#endif
+  }
+
+  // returns the frequency in mHz our steppers play the note passed in at
+  constexpr uint32_t noteMilliHz(const uint8_t note) {
+    return exactMilliHz(foldNote(note));
+  }
+
+  // the frequency ratio of half a semitone, the twenty fourth root of two
+  constexpr double quarterToneRatio = 1.02930223664349206922;
+
+  // the frequencies in mHz our range starts at, and ends just short of
+  // half a semitone beyond our lowest and highest notes, so that every note
+  // sits well inside our range no matter how its frequency was rounded
+  constexpr uint32_t rangeFloor = (uint32_t)(exactMilliHz(MIDI_NOTE_LOWEST) / quarterToneRatio + 0.5);
+  constexpr uint32_t rangeCeiling = (uint32_t)(exactMilliHz(MIDI_NOTE_HIGHEST) * quarterToneRatio + 0.5);
+
+  // moves the frequency passed in by whole octaves until it lies within our range
+  // for pitches that fall between our notes, such as those of a bend or glide
+  constexpr uint32_t foldMilliHz(const uint32_t freq) {
+    return (freq >= rangeCeiling) ? foldMilliHz(freq / 2) : ((freq < rangeFloor) ? foldMilliHz(freq * 2) : freq);
+  }
+
+  // returns true if every note from the one passed in upwards is within 1 mHz
+  // of twice the frequency of the note an octave beneath it
+  constexpr bool octavesDouble(const uint8_t note) {
+    return (note + 12 >= MIDI_NOTE_COUNT) || ((exactMilliHz(note + 12) + 1 >= 2 * exactMilliHz(note)) && (exactMilliHz(note + 12) <= 2 * exactMilliHz(note) + 1) && octavesDouble(note + 1));
+  }
+
+  static_assert(exactMilliHz(MIDI_CONCERT_NOTE) == MIDI_CONCERT_PITCH, "our concert pitch note must play at our concert pitch");
+  static_assert(exactMilliHz(MIDI_CONCERT_NOTE + 12) == 2 * MIDI_CONCERT_PITCH, "the octave above our concert pitch must be exactly double");
+  static_assert(exactMilliHz(MIDI_CONCERT_NOTE - 12) == MIDI_CONCERT_PITCH / 2, "the octave below our concert pitch must be exactly half");
+  static_assert(octavesDouble(0), "every octave must double in frequency");
+  static_assert(noteMilliHz(MIDI_NOTE_HIGHEST + 1) == exactMilliHz(MIDI_NOTE_HIGHEST - 11), "notes above our range must fold down by an octave");
+  static_assert(foldMilliHz(exactMilliHz(MIDI_NOTE_HIGHEST + 1)) + 1 >= exactMilliHz(MIDI_NOTE_HIGHEST - 11), "frequencies above our range must fold down by an octave");
+  static_assert(foldMilliHz(exactMilliHz(MIDI_NOTE_HIGHEST + 1)) <= exactMilliHz(MIDI_NOTE_HIGHEST - 11) + 1, "frequencies above our range must fold down by an octave");
+
+  // the frequency ratio between neighbouring cents, the twelve hundredth root of two
+  constexpr double centRatio = 1.00057778950655485929679257579;
+
+  // returns our cent ratio raised to the power passed in
+  constexpr double centPow(const uint8_t cents) {
+    return (cents == 0) ? 1.0 : centRatio * centPow(cents - 1);
+  }
+
+  // returns the frequency multiplier of the number of cents passed in
+  // as a 16.16 fixed point value, rounded to the nearest step
+  constexpr uint32_t centMultiplier(const uint8_t cents) {
+    return (uint32_t)(centPow(cents) * 65536.0 + 0.5);
+  }
+
+  static_assert(centMultiplier(0) == 65536, "no cents must leave a frequency unchanged");
+  static_assert(centMultiplier(50) == (uint32_t)(quarterToneRatio * 65536.0 + 0.5), "half a semitone must match our quarter tone ratio");
+  static_assert(centMultiplier(100) == (uint32_t)(semitoneRatio * 65536.0 + 0.5), "a whole semitone must match our semitone ratio");
+
+  // these build a sequence of every midi note number, or every cent of a semitone,
+  // at compile time so that our tables can be filled in a single constant expression
+  template <uint8_t... notes>
+  struct noteSequence {};
+
+  template <uint8_t count, uint8_t... notes>
+  struct makeNoteSequence : makeNoteSequence<count - 1, count - 1, notes...> {};
+
+  template <uint8_t... notes>
+  struct makeNoteSequence<0, notes...> {
+    typedef noteSequence<notes...> type;
+  };
+
+  // returns a table holding the frequency of every note in our sequence
+  template <uint8_t... notes>
+  constexpr std::array<uint32_t, sizeof...(notes)> buildNoteTable(noteSequence<notes...>) {
+    return { { noteMilliHz(notes)... } };
+  }
+
+  // returns a table holding the frequency of every note in our sequence before folding
+  template <uint8_t... notes>
+  constexpr std::array<uint32_t, sizeof...(notes)> buildExactTable(noteSequence<notes...>) {
+    return { { exactMilliHz(notes)... } };
+  }
+
+  // returns a table holding the multiplier of every cent in our sequence
+  template <uint8_t... cents>
+  constexpr std::array<uint32_t, sizeof...(cents)> buildCentTable(noteSequence<cents...>) {
+    return { { centMultiplier(cents)... } };
+  }
+
+  // returns a table containing the frequency in mHz of every midi note
+  // the table is worked out entirely at compile time and kept in flash
+  // so that playback only ever needs to index into it
+  const std::array<uint32_t, MIDI_NOTE_COUNT>& freqTable(void);
+
+  // returns a table containing the frequency in mHz of every midi note
+  // as it would sound unfolded, for pitches that are worked out between notes
+  // and folded into our range once they are known
+  const std::array<uint32_t, MIDI_NOTE_COUNT>& exactFreqTable(void);
+
+  // returns a table containing the frequency multiplier of every cent
+  // within a semitone, up to and including a whole semitone
+  // as 16.16 fixed point values worked out at compile time
+  const std::array<uint32_t, 101>& centTable(void);
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef MIDI_TEMPOMAP_HPP
+#define MIDI_TEMPOMAP_HPP
+#include "globals.hpp"
+#include <vector>
+
+// the tempo midi files use until they specify otherwise
+// in uS per quarter note, equivalent to 120 beats per minute
+#define MIDI_DEFAULT_TEMPO 500000
+
+// this class keeps track of every tempo used by our midi file and the tick
+// at which each takes effect, allowing us to convert any absolute time in ticks
+// to an absolute time in uS. our conversions are done with 64 bit integers
+// and only ever divide once, so no rounding error builds up over a song
+class tempoMap {
+  struct tempoSegment {
+    // the absolute time in ticks at which this tempo takes effect
+    uint64_t tick = 0;
+
+    // the absolute time at which this tempo takes effect in uS,
+    // multiplied by our ticks per quarter note so that it is always exact
+    uint64_t scaledMicros = 0;
+
+    // the tempo of this segment in uS per quarter note
+    uint32_t tempo = MIDI_DEFAULT_TEMPO;
+  };
+
+  // every tempo of our song, in the order they take effect
+  // there is always at least one segment, starting at tick 0
+  std::vector<tempoSegment> segments;
+
+  // the division from our midi file's header chunk
+  uint16_t headerDiv = 0;
+
+  // when our division is timecode based, ticks are converted to uS
+  // by multiplying by smpteNum then dividing by smpteDen
+  // these are worked out once when our map is reset
+  uint64_t smpteNum = 0;
+  uint64_t smpteDen = 0;
+
+  // returns the segment in effect at the tick passed in
+  const tempoSegment& findSegment(const uint64_t tick) const;
+
+  public:
+  tempoMap(void);
+
+  // clears our map, leaving only our default tempo starting at tick 0
+  // headerDiv is the division read from our midi file's header chunk
+  void reset(const uint16_t headerDiv);
+
+  // adds a tempo taking effect at the tick passed in
+  // tempos must be added in order; a tempo added at the same tick
+  // as the previous one replaces it
+  void addTempo(const uint64_t tick, const uint32_t tempo);
+
+  // discards every tempo but the most recent. used when our ticks
+  // will only ever increase, so that our map doesn't grow over a song
+  void discardHistory(void);
+
+  // converts an absolute time in ticks to an absolute time in uS
+  uint64_t toMicros(const uint64_t tick) const;
+};
+
+#endif
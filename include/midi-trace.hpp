@@ -0,0 +1,65 @@
+#ifndef MIDI_TRACE_HPP
+#define MIDI_TRACE_HPP
+#include "globals.hpp"
+#include "sdio-songCache.hpp"
+
+// the number of trace records that can wait to be drained at once
+// records traced while our trace is full are dropped and counted
+// this must be a power of two
+#define TRACE_RECORDS 256
+
+// the most trace records drained each time drainTrace() is called
+// so that draining never holds up our loop for long
+#define TRACE_DRAIN_MAX 16
+
+// when true, our trace records are written as they are to TRACE_FILE
+// rather than being printed to our serial monitor
+#define TRACE_TO_FILE false
+
+// the file our trace records are written to, which is started over with every song
+#define TRACE_FILE SONG_CACHE_DIR "/trace.bin"
+
+// this struct describes a single event played by our playback task
+// records are fixed size and written without allocating, so that tracing
+// costs our playback task next to nothing
+struct traceRecord {
+  // the time our event was played according to esp_timer_get_time()
+  uint32_t timestamp;
+
+  // the time in uS by which our event was played late
+  uint32_t lateness;
+
+  // the midi status byte of our event, holding both its type and channel
+  uint8_t event;
+
+  // the midi note number of our event
+  uint8_t note;
+
+  // the stepper our event was played on, or NOT_FOUND if none was available
+  uint8_t stepperIdx;
+
+  uint8_t reserved = 0;
+};
+static_assert(sizeof(traceRecord) == 12, "traceRecord must remain 12 bytes");
+
+// tracing only exists in debug builds. otherwise these functions
+// do nothing and are compiled out entirely
+#if SERIAL_DEBUG
+// clears any records left over from our previous song
+// must be called before our playback task begins tracing a new song
+void beginTrace(void);
+
+// records an event played by our playback task. this is the only
+// function that may be called from our playback task
+void traceEvent(const uint32_t timestamp, const uint8_t event, const uint8_t note, const uint8_t stepperIdx, const uint32_t lateness);
+
+// prints or writes out up to TRACE_DRAIN_MAX waiting records
+// this must be called regularly from our loop
+void drainTrace(void);
+#else
+inline void beginTrace(void) {}
+inline void traceEvent(const uint32_t timestamp, const uint8_t event, const uint8_t note, const uint8_t stepperIdx, const uint32_t lateness) {}
+inline void drainTrace(void) {}
+#endif
+
+#endif
@@ -1,7 +1,16 @@
 #ifndef MIDI_HPP
 #define MIDI_HPP
 #include "globals.hpp"
+#include "midi-byteSource.hpp"
+#include "midi-clockSync.hpp"
+#include "midi-noteTable.hpp"
+#include "midi-tempoMap.hpp"
+#include "ringBuffer.hpp"
+#include "uart-midiParser.hpp"
+#include <esp_timer.h>
 #include <array>
+#include <atomic>
+#include <deque>
 #include <memory>
 #include <queue>
 #include <vector>
@@ -18,6 +27,10 @@
 // and is the hexadecimal representation of MTrk
 #define CHUNKTYPE_TRACK 0x4d54726b
 
+// the greatest number of tracks we can parse in a single midi file
+// as our events refer to their track with a single byte
+#define MIDI_TRACK_MAX 255
+
 // this HEX value represents meta events as used by midi files
 #define MIDI_META_EVENT 0xFF
 
@@ -29,6 +42,36 @@
 // the lower nibble of this value varies and denotes its channel
 #define MIDI_NOTE_OFF 0x80
 
+// this HEX value represents control change events as used by midi files
+// the lower nibble of this value varies and denotes its channel
+#define MIDI_CONTROL_CHANGE 0xB0
+
+// this HEX value represents pitch bend events as used by midi files
+// the lower nibble of this value varies and denotes its channel
+#define MIDI_PITCH_BEND 0xE0
+
+// the controllers our steppers respond to, any others are discarded
+// our mod wheel, which sets the depth of our vibrato
+#define MIDI_CC_MODULATION 1
+
+// the time and on/off switch of our portamento glides
+#define MIDI_CC_PORTAMENTO_TIME 5
+#define MIDI_CC_PORTAMENTO 65
+
+// data entry, along with the RPN number it applies to
+// used to set our pitch bend range
+#define MIDI_CC_DATA_ENTRY 6
+#define MIDI_CC_DATA_ENTRY_LSB 38
+#define MIDI_CC_RPN_LSB 100
+#define MIDI_CC_RPN_MSB 101
+
+// returns our pitch bend and mod wheel to centre
+#define MIDI_CC_RESET_CONTROLLERS 121
+
+// never acted on by our steppers, but sent to the devices following our song
+// through our UART once it is stopped
+#define MIDI_CC_ALL_NOTES_OFF 123
+
 // this HEX values accompanies meta events within midi files
 // and is used to denote the end of a track
 #define MIDI_META_EOT 0x2F
@@ -37,13 +80,6 @@
 // and is used to denote a tempo change
 #define MIDI_META_TEMPO 0x51
 
-// this arbitrary value is used to cap our upper octave
-// this is used to ensure we don't send a note to our stepper motor
-// whose frequency is too great for us to play
-#define MIDI_OCTAVE_MAX 6
-
-#define MIDI_OCTAVE_MIN -2
-
 // one of four SMPTE standard values denoting 24 frames per second
 #define SMPTE_24 0xE8
 
@@ -64,10 +100,10 @@
 // octave 3:  c = 130,   c# = 138,    d = 146,   d# = 155,   e = 164,     f = 174,    f# = 185,    g = 196,    g# = 208,    a = 220,    a# = 233,    b = 246
 // octave 4:  c = 261,   c# = 277,    d = 293,   d# = 311,   e = 329,     f = 349,    f# = 369,    g = 392,    g# = 415,    a = 440,    a# = 466,    b = 493
 // octave 5:  c = 523,   c# = 554,    d = 587,   d# = 622,   e = 659,     f = 698,    f# = 739,    g = 784,    g# = 830,    a = 880,    a# = 932,    b = 987
-// octave 6:  c = 1046,  c# = 1108,   d = 1174,  d# = 1244,  e = 1318,    f = 1396,   f# = 1479,   g = 1567,   g# = 1161,   a = 1760,   a# = 1864,   b = 1975
+// octave 6:  c = 1046,  c# = 1108,   d = 1174,  d# = 1244,  e = 1318,    f = 1396,   f# = 1479,   g = 1567,   g# = 1661,   a = 1760,   a# = 1864,   b = 1975
 // octave 7:  c = 2093,  c# = 2217,   d = 2349,  d# = 2489,  e = 2637,    f = 2793,   f# = 2959,   g = 3135,   g# = 3324,   a = 3520,   a# = 3729,   b = 3951
 // octave 8:  c = 4186,  c# = 4434,   d = 4698,  d# = 4978,  e = 5274,    f = 5587,   f# = 5919,   g = 6271,   g# = 6644,   a = 7040,   a# = 7458,   b = 7902
-// using our getFreq function, we can generate a frequency within <1hz of expected for each note in each octave
+// our note table in midi-noteTable.hpp holds each of these to within 1mHz of equal temperament
 
 // midi uses a single 7 bit integer to reference various notes across a range of octaves
 //             C  |  C#  |  D   |  D#  |  E   |  F   |  F#  |  G   |  G#  |  A   |  A#  |  B
@@ -94,6 +130,155 @@
 // then the message bytes and always ends with an 0xF7
 // the length indicates the number of message bytes plus the closing 0xF7
 
+// these values are stored in the eventKind of our playback events
+// and tell our player what to do with each event
+#define PLAYBACK_NOTE_OFF 0x00
+#define PLAYBACK_NOTE_ON 0x01
+
+// a rest carries no note and only exists to hold any delta time
+// too long to fit in a single playback event
+#define PLAYBACK_REST 0x02
+
+// a pitch bend holds the lower 7 bits of its value in our note
+// and the upper 7 bits in our velocity
+#define PLAYBACK_PITCH_BEND 0x03
+
+// a control change holds its controller number in our note
+// and its value in our velocity
+#define PLAYBACK_CONTROL 0x04
+
+// a tempo change holds its tempo in uS per quarter note across our note,
+// velocity and channel, most significant byte first
+// it is only followed while our song keeps its own time
+#define PLAYBACK_TEMPO 0x05
+
+// the largest delta time in ticks that a single playback event can hold
+#define PLAYBACK_DELTA_MAX 0xFFFFFF
+
+// the number of playback events held in our lookahead window during playback
+// events are moved into this window ahead of time, and the window is
+// topped back up from our loop while our playback task plays them
+// this must be a power of two
+#define MIDI_LOOKAHEAD 64
+
+// if our lookahead window runs dry during playback, our playback timer
+// checks back for more events after this many uS
+#define MIDI_UNDERRUN_RETRY 1000
+
+// our playback task runs on the opposite core from our rotary encoder's task
+// and above it in priority, so that our notes are played on time
+#define MIDI_PLAYBACK_CORE 0
+#define MIDI_PLAYBACK_PRIORITY 3
+
+// the stack size in bytes of our playback task
+#define MIDI_PLAYBACK_STACK 4096
+
+// the notification bits our playback task is woken with
+// telling it whether events are due, the pitch of our notes needs updating
+// or live messages have arrived over our UART
+#define MIDI_NOTIFY_EVENTS 0x01
+#define MIDI_NOTIFY_CONTROL 0x02
+#define MIDI_NOTIFY_LIVE 0x04
+
+// the notification bits other tasks use to ask our playback task to reset
+// our controllers or silence our steppers, since live input may be
+// playing notes on them at any moment, or to start our song
+#define MIDI_NOTIFY_RESET 0x08
+#define MIDI_NOTIFY_SILENCE 0x10
+#define MIDI_NOTIFY_START 0x20
+
+// the size in bytes of the block each track reads from our SD card
+// when our midi file is parsed incrementally during playback
+#define MIDI_TRACK_BLOCK_SIZE 64
+
+// this struct is the compact form our events take once parsing is finished
+// only what is needed during playback is kept, and frequencies are looked up
+// from our note number as each event is played rather than being stored
+// times are kept in ticks, so that our song can follow either its own tempo
+// changes or the clock of a master device as it plays
+struct playbackEvent {
+  // time in ticks since the previous playback event
+  uint32_t deltaTime : 24;
+
+  // one of the PLAYBACK_ values defined above
+  uint32_t eventKind : 8;
+
+  // the midi note number of our event, 0 - 127
+  // or the first data byte of a pitch bend or control change
+  uint8_t note;
+
+  // the channel our event occurs on, 0 - 15
+  uint8_t channel;
+
+  // the track our event was read from
+  uint8_t track;
+
+  // the velocity of our note. unused by our steppers for volume,
+  // but kept so that voice allocation may make use of it
+  // or the second data byte of a pitch bend or control change
+  uint8_t velocity;
+};
+static_assert(sizeof(playbackEvent) == 8, "playbackEvent must remain 8 bytes");
+
+// if the notes of a track overlap one another for longer than this
+// on average, measured in uS of overlap per note, we consider the track to be polyphonic
+// averaging keeps a long song with a handful of brief overlaps monophonic
+#define MIDI_POLYPHONY_THRESHOLD 250000
+
+// this struct describes how the notes of a single track overlap one another
+// and is filled in by our polyphony analysis for use by voice allocation
+struct trackProfile {
+  // the number of note on events in our track
+  uint32_t noteCount = 0;
+
+  // the time in uS each note of our track spends sounding alongside another
+  // added up over every note, so that dividing by our noteCount gives our average overlap
+  uint64_t overlapTime = 0;
+
+  // the greatest number of notes of our track sounding at once
+  uint8_t maxVoices = 0;
+
+  // true while our overlapTime divided by our noteCount exceeds MIDI_POLYPHONY_THRESHOLD
+  bool polyphonic = false;
+};
+
+// this struct holds measurements taken while our midi file is parsed
+// so that the cost of any change to our parser can be judged on real files
+struct parseStats {
+  // the number of bytes and events read from our midi file
+  uint32_t bytesRead = 0;
+  uint32_t eventsRead = 0;
+
+  // the time taken to parse our midi file in uS
+  uint32_t parseTime = 0;
+
+  // the time in uS from the start of our song to its last event
+  // left as 0 when our song is parsed incrementally
+  uint64_t songLength = 0;
+};
+
+// this struct holds measurements of how closely our events were played
+// to the time they were scheduled for, taken over a single song
+struct playbackStats {
+  // the number of note, pitch bend and control change events played
+  uint32_t eventsPlayed = 0;
+
+  // the number of times our lookahead window was found empty
+  // while our song still had events left to play
+  uint32_t underruns = 0;
+
+  // the least, total, and greatest time in uS by which our events were played late
+  uint32_t minLateness = UINT32_MAX;
+  uint64_t totalLateness = 0;
+  uint32_t maxLateness = 0;
+
+  // the fewest and most events our lookahead window held before our song
+  // ran out of events to fill it with. a low watermark near 0 means our window
+  // is close to running dry, and MIDI_LOOKAHEAD should be raised
+  uint32_t lookaheadLow = 0;
+  uint32_t lookaheadHigh = 0;
+};
+
 // this struct will be used to store the contents of our MIDI file once loaded
 // much of the information this is based off of is thanks to the documentation
 // at https://www.music.mcgill.ca/~ich/classes/mumt306/StandardMIDIfileformat.html
@@ -139,22 +324,192 @@ class midiFile {
 
     uint8_t track = 0;
 
+    // the velocity of note on and note off events
+    uint8_t velocity = 0;
+
     // ## true to isolate our event type, false to isolate our channel
     // this is a simple function that performs common bit manipulation
     // on our 8 bit integers to separate values out of a single byte
     uint8_t getEventOrChannel(bool event);
   };
 
+  // this struct refers to the next event of a single track
+  // and is used to merge our tracks together in time order
+  struct trackHead {
+    // the absolute time of our track's next event
+    uint32_t deltaTime;
+
+    // tempo events are given a priority of 0 so they are placed
+    // ahead of any other event occurring at the same time
+    uint8_t priority;
+
+    uint8_t track;
+
+    // used to order our heap of track heads, earliest event first
+    bool operator>(const trackHead& other) const;
+  };
+
+  // when our midi file is parsed incrementally, each track chunk
+  // is read through its own cursor, which remembers where in
+  // the track we are and holds the track's next event until it is merged
+  struct trackCursor {
+    // streams the bytes of this track chunk off of our SD card
+    fileByteSource source;
+
+    // the number of bytes in this track chunk that have yet to be parsed
+    uint32_t remaining = 0;
+
+    // the status of the last event read, used for running status
+    uint8_t prevEvent = 0;
+
+    // the absolute time of the last event read from this track
+    uint64_t absoluteDT = 0;
+
+    uint8_t trackNum = 0;
+
+    // the next event of this track, waiting to be merged
+    midiEvent next;
+
+    trackCursor(FsFile* file, const uint64_t start, const uint32_t length, const uint8_t trackNum);
+  };
+
+  // our polyphony analysis keeps one of these for each track
+  // tracking which notes of that track are currently sounding
+  struct voiceState {
+    // the number of times each note is currently sounding
+    std::array<uint8_t, 128> notes {};
+
+    // the total number of notes currently sounding
+    uint8_t active = 0;
+
+    // the time in uS at which the number of notes sounding last changed
+    uint64_t lastChange = 0;
+  };
+
   /* member variable definitions below */
 
-  // the purpose of this queue is to hold the contents
-  // of our midi file for parsing
-  std::queue<uint8_t>* byteArray = NULL;
+  // the source we read the contents of our midi file from for parsing
+  // this may either hold our entire file in memory or stream it from our SD card
+  midiByteSource* byteSource = NULL;
+
+  // this vector will contain our parsed midi events in playback order, ready for playback
+  // these events will exclusively consist of note on, note off, pitch bend
+  // and control change events, along with any rests needed to hold long delta times
+  std::vector<playbackEvent>* eventQueue = NULL;
+
+  // the index of the next event in our eventQueue
+  // to be moved into our lookahead window
+  size_t queueIdx = 0;
+
+  // when parsing incrementally, these cursors take the place of our eventQueue
+  // holding one cursor per track chunk in our midi file
+  std::vector<trackCursor>* trackCursors = NULL;
+
+  // a heap holding the next event of each of our track cursors
+  // the earliest of which is always at the front
+  std::vector<trackHead> mergeFront;
+
+  // the events that will be played next. this is filled from either
+  // our eventQueue or our track cursors, and is topped up during playback
+  ringBuffer<playbackEvent, MIDI_LOOKAHEAD> lookahead;
+
+  // when parsing incrementally, the merged event that will be turned into our
+  // next playback event, along with whether we're currently holding one
+  midiEvent heldEvent;
+  bool holdingEvent = false;
+
+  // when parsing incrementally, the time in ticks that has built up
+  // since the last playback event we produced
+  uint64_t pendingDeltaTime = 0;
+
+  // every tempo change in our song, used to convert absolute times in ticks to uS
+  tempoMap tempos;
+
+  // when parsing incrementally, the absolute time in ticks of the last event we merged
+  uint64_t lastTick = 0;
+
+  // the state of each track during our polyphony analysis
+  std::vector<voiceState> voiceStates;
+
+  // measurements taken during our most recent parse
+  parseStats stats;
+
+  // set whenever we find our midi file to be malformed, such as a length
+  // running past the end of our file, after which parsing stops
+  bool parseError = false;
+
+  // the one shot timer that wakes our playback task each time an event is due
+  // it is rearmed for our next event every time it fires
+  esp_timer_handle_t playbackTimer = NULL;
 
-  // this queue will contain our parsed midi events, ready for playback
-  // these events will exclusively consist of note on events;
-  // note off events will be represented with a velocity of zero
-  std::queue<midiEvent>* eventQueue = NULL;
+  // the periodic timer that wakes our playback task to update the pitch
+  // of our sounding notes, every MODULATION_PERIOD uS while our song plays
+  // or for as long as live input is enabled
+  esp_timer_handle_t controlTimer = NULL;
+
+  // the task that plays our events. our lookahead window is filled from our loop
+  // and emptied only by this task, so it needs no lock
+  // it is the only task that touches our steppers
+  TaskHandle_t playbackTask = NULL;
+
+  // true once live input has been started, after which our playback task
+  // plays every message arriving over our UART, whether or not a song is playing
+  std::atomic<bool> liveInput { false };
+
+  // the MIDI_NOTIFY_RESET, MIDI_NOTIFY_SILENCE and MIDI_NOTIFY_START requests
+  // our playback task has yet to carry out
+  std::atomic<uint32_t> pendingRequests { 0 };
+
+  // true from the moment our song starts playing until its events are released
+  bool songLoaded = false;
+
+  // true while our playback timer is running
+  std::atomic<bool> playing { false };
+
+  // true while our playback task is playing events
+  std::atomic<bool> dispatching { false };
+
+  // true until every event of our song has been moved into our lookahead window
+  std::atomic<bool> eventsRemaining { false };
+
+  // the time our song started according to esp_timer_get_time()
+  // along with the absolute time in ticks at which our next event is due
+  // every event is scheduled against the start of our song
+  // so that time spent between events never builds up into drift
+  int64_t songStart = 0;
+  uint64_t songTick = 0;
+
+  // the tempo changes our playback task has come across so far
+  // used to turn our ticks into uS while our song keeps its own time
+  tempoMap songTempos;
+
+  // false until the first event of our song has been played
+  // while our song keeps its own time, its start is measured from that event
+  // however long our file waits before it
+  bool songStarted = false;
+
+  // the clock of the master device driving our song over our UART, if any
+  // and whether our song follows it rather than its own tempo
+  // only ever used by our playback task
+  clockSync externalClock;
+  bool slaved = false;
+
+  // the channels our song has played notes on through our UART's thru
+  // which are sent all notes off if our song is stopped part way through
+  // only ever used by our playback task
+  uint16_t thruChannels = 0;
+
+  // set by our playback task when our master sends our song back to its start
+  // our loop then refills our lookahead window from our first event
+  // and clears it again, with our playback task leaving our window alone until then
+  std::atomic<bool> rewindPending { false };
+
+  // the event taken from our lookahead window that our timer is waiting on
+  playbackEvent pendingEvent;
+  bool eventPending = false;
+
+  // measurements taken while playing our current song
+  playbackStats playStats;
 
   /* member function prototypes below */
 
@@ -167,17 +522,125 @@ class midiFile {
   // is fully parsed, then exit. returns false if an error occurs
   bool populateTrackChunks(const uint8_t trackNum, std::deque<midiEvent>& trackData);
 
+  // reads a single event from our byteSource, storing it in event
+  // prevEvent and absoluteDT carry running status and absolute time
+  // from one event of a track to the next. limit is the number of bytes
+  // left in our track. returns the number of bytes read
+  uint32_t readTrackEvent(uint8_t& prevEvent, uint64_t& absoluteDT, midiEvent& event, const uint32_t limit);
+
+  // returns true if the event passed in is one we need for playback
+  // note on, note off, pitch bend, tempo events, and the controllers
+  // listed above are the only ones we make use of
+  bool isPlaybackEvent(const midiEvent& event);
+
+  // reads through the track of the cursor passed in until its next
+  // playback event is found and stored in the cursor
+  // returns false once the track has no events left
+  bool advanceCursor(trackCursor& cursor);
+
+  // builds the trackHead referring to the event passed in
+  trackHead makeHead(const midiEvent& event);
+
+  // takes the earliest event from our merge front, storing it in event,
+  // and replaces it with the next event from the same track
+  // returns false once every track has been fully merged
+  bool mergeNext(midiEvent& event);
+
+  // builds the playback event for a note on, note off
+  // pitch bend or control change event
+  playbackEvent packEvent(const midiEvent& event, const uint32_t deltaTime);
+
+  // builds a rest, used to hold delta times too long for a single playback event
+  playbackEvent packRest(void);
+
+  // produces our next playback event, either from our eventQueue
+  // or by merging the next events of our track cursors
+  // returns false once there are no events left
+  bool produceEvent(playbackEvent& event);
+
+  // moves playback events into our lookahead window until it is full
+  // or we have run out of events
+  void fillLookahead(void);
+
+  // frees our eventQueue and track cursors once playback is finished
+  void releaseEvents(void);
+
+  // called by our playback timer, which passes in our midiFile
+  // this wakes our playback task to play our events
+  static void playbackCallback(void* arg);
+
+  // called by our control timer, which passes in our midiFile
+  // this wakes our playback task to update the pitch of our notes
+  static void controlCallback(void* arg);
+
+  // the body of our playback task, which plays our events each time it is woken
+  static void playbackLoop(void* pvParameters);
+
+  // creates our playback task and timers if they don't exist yet
+  // returns false if any of them couldn't be created
+  bool startTask(void);
+
+  // asks our playback task to carry out the MIDI_NOTIFY_RESET or
+  // MIDI_NOTIFY_SILENCE requests passed in, waiting until it has
+  void request(const uint32_t requests);
+
+  // records how full our lookahead window has been kept
+  void recordWatermarks(void);
+
+  // plays every event that has come due, then rearms our playback timer
+  // for the next event, or stops it once our song has finished
+  void dispatchEvents(void);
+
+  // moves the pitch of our sounding notes along their bends, vibrato and glides
+  void dispatchControl(void);
+
+  // plays every live message waiting in our UART's queue
+  // note ons with a velocity of 0 are played as note offs
+  void dispatchLive(void);
+
+  // decides whether our song follows our master's clock or its own tempo
+  // a song started while a clock is arriving follows our master from its next clock
+  // or waits for it to be started, otherwise it begins playing straight away
+  void beginSong(void);
+
+  // applies a clock, start, continue or stop from our master to our song
+  // returns true if our song may have events that have come due
+  bool applyTransport(const liveMessage& message);
+
+  // moves our song from its own tempo over to our master's clock
+  // picking up from the next event it was waiting on
+  void followClock(void);
+
+  // sends our song back to its first event, called from our loop
+  // once our playback task has asked for it
+  void rewind(void);
+
+  // starts or stops our control timer, returning false if it couldn't be started
+  // our control timer is left running while live input is enabled
+  bool startControl(void);
+  void stopControl(void);
+
+  // reports on and releases a song that has finished or been stopped
+  void finishPlayback(void);
+
+  // clears our parse stats and records the time parsing began
+  void beginStats(void);
+
+  // records the time taken to parse once parsing has finished
+  void endStats(void);
+
   // with this function we check the type of midi event that we're reading
   uint8_t readMidiEvent(uint8_t& prevEvent, uint8_t& eventType);
 
   // this function will read in byte by byte our midi event data
-  // and prepare them for parsing
-  uint8_t readMidiEventData(const uint8_t eventType, uint8_t& metaType, uint32_t& eventData);
+  // and prepare them for parsing. limit is the number of bytes left in our track
+  // and any event claiming to be longer than that is treated as an error
+  uint32_t readMidiEventData(const uint8_t eventType, uint8_t& metaType, uint32_t& eventData, const uint32_t limit);
 
   // this function is used to parse variable length quantities
   // converting them to a standard unsigned 32 bit integer
   // this function will read in 4 bytes at most
-  // and consumes them in the process
+  // and consumes them in the process. any longer is treated as an error
   uint8_t readVariableLen(uint32_t& varLenQuantity);
 
   // this function reads the next four bytes in our file
@@ -190,34 +653,53 @@ class midiFile {
   // then stores and returns the 2 byte value
   uint16_t readChunkData16(void);
 
-  // this function returns the first byte in our byteArray
-  // consuming it in the process
+  // this function returns the next byte from our byteSource
+  // consuming it in the process. reading past the end of our
+  // byteSource returns 0 and sets our parseError
   uint8_t readByte(void);
 
-  // we'll be making use of this function to sort our event data by deltaTime
+  // we'll be making use of this function to merge the events of each of our tracks
+  // into a single deque ordered by deltaTime. each track is already in time order,
+  // so we only ever need to compare the next event of each track
   // in the event of two elements having the same deltaTime
   // (i.e., they occur at the same time)
   // any events that change tempo will take priority
-  // and be placed first in our queue
-  void sortEvents(std::deque<midiEvent>& trackData);
+  // and be placed first in our queue. otherwise, events keep the order
+  // of their tracks, and then the order they appear within their track
+  void mergeTracks(std::vector<std::deque<midiEvent>>& tracks, std::deque<midiEvent>& trackData);
 
   // we'll use this function to convert our delta time to
   // a value usable by our stepper motor library
+  // each event's absolute time in ticks is converted to an absolute time in uS
+  // through our tempo map, then made relative to the event before it
   void convertDeltaTime(std::deque<midiEvent>& trackData);
 
   // this function will be used to push all of our midi events
   // into a queue where they will be ready for playback
   void enqueueEvents(std::deque<midiEvent>& trackData);
 
+  // this function sweeps once over our time ordered events, which must already
+  // have been converted to uS, and fills in the profile of each of our tracks
   void analyzeOverlaps(const std::deque<midiEvent>& trackData);
 
+  // clears our track profiles and readies our voice states for analysis
+  void beginAnalysis(void);
+
+  // updates the profile of the event's track with a single note on or note off event
+  // events must be passed in time order, with micros being the event's absolute time
+  void analyzeEvent(const midiEvent& event, const uint64_t micros);
+
   public:
-  std::vector<bool> trackPolyphony;
+  // the profile of each track in our midi file, describing its polyphony
+  std::vector<trackProfile> trackProfiles;
 
-  // a pointer to an array of unsigned 8 bit integers
-  // containing the entirety of our midi file is passed in to this function
-  // which attached that array to our byteArray
-  void assignQueue(std::queue<uint8_t>* fileContents);
+  // releases whatever song we still hold
+  ~midiFile(void);
+
+  // a pointer to the source our midi file will be read from
+  // is passed in to this function, which attaches it to our byteSource
+  // the caller retains ownership of the source, which must outlive parseMidi()
+  void assignSource(midiByteSource* fileContents);
 
   // wrapper function that calls various functions to parse
   // the header chunk of our midi file
@@ -225,23 +707,67 @@ class midiFile {
   // our midi file byte by byte. returns false if we encounter an error
   bool parseMidi(void);
 
+  // prepares our midi file to be parsed incrementally during playback
+  // rather than parsing the whole file ahead of time. only our header
+  // and the location of each track chunk are read here, so playback can begin
+  // almost immediately, and memory use no longer grows with the length of our file
+  // the file passed in must stay open until playback has finished
+  // as our polyphony analysis needs the whole file, tracks played this way
+  // are treated as monophonic. returns false if we encounter an error
+  bool parseMidiIncremental(FsFile* file);
+
+  // writes our header data, track profiles and parsed events to the file passed in
+  // so that they can later be read back by loadEvents() in place of parsing
+  // returns false if any part of our song couldn't be written
+  bool saveEvents(FsFile& file);
+
+  // reads a song previously written by saveEvents() from the file passed in
+  // leaving our events ready for playback. returns false if the file is incomplete
+  // or its header and track count don't match those of the song it was built from
+  bool loadEvents(FsFile& file, FsFile& song);
+
   // finally, this function will call our various stepper motor function to actually play our music
-  void playMidi(void);
+  // playback is driven by a timer, so this returns as soon as our song has started
+  // and updateMidi() must then be called regularly until it returns false
+  // any song already playing must be stopped with stopMidi() before a new one is parsed
+  // returns false if our playback timer couldn't be started
+  bool playMidi(void);
+
+  // keeps our lookahead window topped up while our song plays
+  // and releases our song once it has finished
+  // returns true for as long as our song is still playing
+  bool updateMidi(void);
+
+  // stops our song immediately, silencing our steppers and releasing our song
+  // does nothing if no song is playing
+  void stopMidi(void);
+
+  // starts our playback task playing live messages as they arrive over our UART
+  // returns false if our playback task or timers couldn't be created
+  bool startLive(void);
+
+  // wakes our playback task to play the live messages waiting in our UART's queue
+  // called from our UART's event task once it has queued them
+  void notifyLive(void);
+
+  // this is a debug function used to print how closely the events of our
+  // most recent song were played to the time they were due
+  void printPlayback(void);
+
+  // this is a debug function used to print the measurements taken
+  // during our most recent parse, including events and bytes parsed per second
+  // the heap used by parsing is measured by our host benchmark instead
+  void printStats(void);
+
+  // returns the measurements taken during our most recent parse
+  const parseStats& getStats(void) const;
 
   // this is a debug function used to print the contents of our event queue
   // to our serial monitor so that we can manually inspect our event data
+  // followed by the amount of memory our event queue occupies
   void printQueue(void);
 };
 
-namespace midi {
-  // this array is used to define the frequencies of each note within octave 0, represented in mHz
-  const std::array<uint16_t, 12> noteFreq = { 16350, 17320, 18350, 19450, 20600, 21830, 23120, 24500, 25960, 27500, 29140, 30870 };
-
-  // takes a note frequency and octave and returns the new frequency of the note
-  // at the given octave in Hz. returns 0 if note or octave are invalid
-  uint32_t getFreq(const uint8_t note);
-};
-
 extern midiFile songData;
 
 #endif
\ No newline at end of file
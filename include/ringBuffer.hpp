@@ -0,0 +1,103 @@
+#ifndef RINGBUFFER_HPP
+#define RINGBUFFER_HPP
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// a fixed size first in, first out buffer
+// all of its memory is held within the object itself, so pushing and
+// popping never allocate, and it can hold at most N items at once
+// one task may push while another pops without any locking, so long as
+// only a single task ever pushes and only a single task ever pops
+template <typename T, size_t N>
+class ringBuffer {
+  // our counts below are free to wrap around, which only
+  // works out if N divides evenly into their range
+  static_assert(N > 0 && (N & (N - 1)) == 0, "ringBuffer size must be a power of two");
+
+  // the items held in our buffer
+  std::array<T, N> buffer;
+
+  // the number of items ever pushed to and popped from our buffer
+  // each is only ever written by one side, and their difference
+  // is the number of items currently held in our buffer
+  std::atomic<size_t> pushCount { 0 };
+  std::atomic<size_t> popCount { 0 };
+
+  // the most items our buffer has held after a push, and the fewest
+  // it has been left holding after a pop, since our watermarks were last reset
+  std::atomic<size_t> highMark { 0 };
+  std::atomic<size_t> lowMark { N };
+
+  public:
+  // adds an item to the back of our buffer
+  // returns false if our buffer is already full
+  bool push(const T& item) {
+    const size_t tail = this->pushCount.load(std::memory_order_relaxed);
+    const size_t count = tail - this->popCount.load(std::memory_order_acquire);
+    if (count == N) {
+      return false;
+    }
+    this->buffer[tail & (N - 1)] = item;
+    this->pushCount.store(tail + 1, std::memory_order_release);
+    if (count + 1 > this->highMark.load(std::memory_order_relaxed)) {
+      this->highMark.store(count + 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  // removes the item at the front of our buffer, storing it in item
+  // returns false if our buffer is empty
+  bool pop(T& item) {
+    const size_t head = this->popCount.load(std::memory_order_relaxed);
+    const size_t count = this->pushCount.load(std::memory_order_acquire) - head;
+    if (count == 0) {
+      return false;
+    }
+    item = this->buffer[head & (N - 1)];
+    this->popCount.store(head + 1, std::memory_order_release);
+    if (count - 1 < this->lowMark.load(std::memory_order_relaxed)) {
+      this->lowMark.store(count - 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  // removes every item from our buffer and resets our watermarks
+  // neither side may be using our buffer while it is cleared
+  void clear(void) {
+    this->pushCount = 0;
+    this->popCount = 0;
+    resetWatermarks();
+  }
+
+  // starts our watermarks over from our buffer's current size
+  void resetWatermarks(void) {
+    this->highMark = size();
+    this->lowMark = size();
+  }
+
+  size_t size(void) const {
+    return this->pushCount.load(std::memory_order_acquire) - this->popCount.load(std::memory_order_acquire);
+  }
+
+  bool empty(void) const {
+    return size() == 0;
+  }
+
+  bool full(void) const {
+    return size() == N;
+  }
+
+  // the most items our buffer has held at once
+  size_t highWatermark(void) const {
+    return this->highMark.load(std::memory_order_relaxed);
+  }
+
+  // the fewest items our buffer has been left holding once an item was popped
+  // a low watermark of 0 means our buffer has been drained at least once
+  size_t lowWatermark(void) const {
+    return this->lowMark.load(std::memory_order_relaxed);
+  }
+};
+
+#endif
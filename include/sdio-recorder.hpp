@@ -0,0 +1,141 @@
+#ifndef SDIO_RECORDER_HPP
+#define SDIO_RECORDER_HPP
+#include "globals.hpp"
+#include "ringBuffer.hpp"
+#include "uart-midiParser.hpp"
+#include "SdFat.h"
+#include <array>
+#include <atomic>
+#include <string>
+
+// the number of live messages that can wait to be written at once
+// messages received while our queue is full are dropped and counted
+// this must be a power of two
+#define RECORD_QUEUE 1024
+
+// the size in bytes of each write to our file, matching our SD card's sectors
+// so that every write covers whole sectors and never has to read one back first
+#define RECORD_SECTOR 512
+
+// the number of bytes our file is preallocated with. its clusters are claimed
+// in one contiguous run up front, so no write during a performance ever waits
+// on our FAT being searched for free space. enough for over 20 minutes
+// of a saturated UART, and far longer for any real performance
+#define RECORD_PREALLOCATE (4UL << 20)
+
+// our recordings are a single track of a format 0 file, timed by
+// RECORD_DIVISION ticks per quarter note at a tempo of RECORD_TEMPO uS per quarter note
+// at 960 ticks per quarter note and 120 beats per minute, each tick lasts about 520uS
+#define RECORD_DIVISION 960
+#define RECORD_TEMPO 500000
+
+// our recordings are named RECORD_NAME followed by the first free number
+// below RECORD_NAME_LIMIT, and saved in the directory we are looking at
+#define RECORD_NAME "live"
+#define RECORD_NAME_LIMIT 1000
+
+// how often in mS our writing task drains our queue while recording
+#define RECORD_PERIOD 20
+
+// the stack size in bytes, priority and core of our writing task
+// it shares our loop's core and priority, leaving our playback task undisturbed
+#define RECORD_STACK 4096
+#define RECORD_PRIORITY 1
+#define RECORD_CORE 1
+
+// the character typed into our serial monitor to start or stop recording
+#define RECORD_COMMAND 'r'
+
+// this class records the live messages arriving over our UART to a midi file
+// on our SD card. messages are queued with the time they arrived by our UART's
+// event task, then turned into track events and gathered into sectors by our
+// writing task, which writes each sector out as soon as it fills
+// so that our UART's event task never waits on our SD card
+class midiRecorder {
+  // the messages waiting to be written to our file
+  // pushed only by our UART's event task and popped only by our writing task
+  ringBuffer<liveMessage, RECORD_QUEUE> messages;
+
+  // the file we are recording to, and its path for our reports
+  FsFile file;
+  std::string path;
+
+  // the sector being filled by our writing task, and how much of it is filled
+  std::array<uint8_t, RECORD_SECTOR> sector;
+  uint16_t sectorUsed = 0;
+
+  // the number of bytes of our file that have been written out so far
+  uint32_t fileUsed = 0;
+
+  // the time our last message arrived, and the time in uS and ticks since
+  // our recording started that it arrived at
+  // our times are built up message by message so that they never wrap around
+  uint32_t lastTimestamp = 0;
+  uint64_t elapsed = 0;
+  uint64_t lastTick = 0;
+
+  // the status byte of the last event we wrote, which later events
+  // with the same status leave out under running status
+  uint8_t runningStatus = 0;
+
+  // our writing task, along with whether it has been asked to finish
+  // and whether it has finished
+  TaskHandle_t writeTask = NULL;
+  std::atomic<bool> finishing { false };
+  std::atomic<bool> finished { false };
+
+  // true while our UART's messages are being queued
+  std::atomic<bool> recording { false };
+
+  // the number of messages written and dropped, and whether a write has failed
+  // once one has, nothing more is written to our file
+  uint32_t written = 0;
+  std::atomic<uint32_t> dropped { 0 };
+  bool writeFailed = false;
+
+  // the body of our writing task
+  static void writeLoop(void* pvParameters);
+
+  // turns every message waiting in our queue into a track event
+  void drainMessages(void);
+
+  // adds a single byte to our sector, writing our sector out once it fills
+  void writeByte(const uint8_t byte);
+
+  // adds a variable length quantity to our sector, as used for delta times
+  void writeVariableLen(const uint32_t value);
+
+  // writes our sector out to our file and starts a new one
+  // only as much of our sector as has been filled is written
+  void flushSector(void);
+
+  // writes our header chunk, the start of our track chunk and our tempo
+  void writeHeader(void);
+
+  // ends our track, fills in its length and trims our file down to what was written
+  void finishFile(void);
+
+  public:
+  // creates a new file in the directory passed in and starts recording to it
+  // returns false if we are already recording or our file couldn't be created
+  bool start(const std::string& dirPath);
+
+  // stops recording, waits for everything queued to be written, and closes our file
+  void stop(void);
+
+  // returns true while we are recording
+  bool isRecording(void) const;
+
+  // queues a message that arrived over our UART to be recorded
+  // this must only be called from our UART's event task
+  void record(const liveMessage& message);
+};
+
+// our recorder of live messages
+extern midiRecorder recorder;
+
+// starts recording to the directory we are looking at, or stops recording
+// if the command passed in is RECORD_COMMAND
+void handleRecordCommand(const char command);
+
+#endif
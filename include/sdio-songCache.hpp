@@ -0,0 +1,46 @@
+#ifndef SDIO_SONGCACHE_HPP
+#define SDIO_SONGCACHE_HPP
+#include "SdFat.h"
+#include <string>
+
+// the hidden directory our parsed songs are cached in
+#define SONG_CACHE_DIR "/.midi"
+
+// this value is written at the start of every cache file
+// and is the hexadecimal representation of SMFC
+#define SONG_CACHE_MAGIC 0x534d4643
+
+// this value must be incremented whenever the layout of our cache files,
+// or the playback events held within them, changes
+// so that any cache files written in an older layout are ignored
+#define SONG_CACHE_VERSION 5
+
+// this struct is written at the start of every cache file
+// and is used to check that the cache still matches the song it was built from
+struct songCacheHeader {
+  uint32_t magic = SONG_CACHE_MAGIC;
+  uint32_t version = SONG_CACHE_VERSION;
+
+  // the size in bytes of the song our cache was built from
+  uint64_t sourceSize = 0;
+
+  // the modification date and time of the song our cache was built from
+  // in the FAT format used by FsFile::getModifyDateTime()
+  uint16_t sourceDate = 0;
+  uint16_t sourceTime = 0;
+};
+
+// returns the path of the cache file belonging to the song at songPath
+// cache files are named after a hash of the song's full path
+std::string songCachePath(const std::string& songPath);
+
+// attempts to load the cache file belonging to the song passed in
+// into our songData, ready for playback. returns false if there is no cache file
+// or if it no longer matches our song, in which case our song must be parsed
+bool loadSongCache(FsFile& song, const std::string& songPath);
+
+// writes the song currently held by our songData, which must have just been
+// parsed from the song passed in, to its cache file
+bool saveSongCache(FsFile& song, const std::string& songPath);
+
+#endif
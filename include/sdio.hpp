@@ -15,6 +15,28 @@
 #define SD_FILE_READ O_RDONLY
 #define SD_FILE_WRITE (O_RDWR | O_CREAT | O_AT_END)
 
+// when true, our midi files are streamed directly from our SD card
+// one block at a time as they are parsed. when false, the entire file
+// is first loaded into memory before parsing begins
+#define SD_STREAM_MIDI true
+
+// when true, songs without a cache are parsed incrementally as they play
+// so that playback starts right away, no matter the length of our file
+// songs played this way aren't analyzed for polyphony or written to our cache
+#define SD_INCREMENTAL_MIDI false
+
+// our SD card may only be used by one task at a time, but our recorder writes to it
+// from its own task while our loop reads from it. a guard holds our card
+// for as long as it is in scope, and guards may be nested within a task
+class sdGuard {
+  public:
+  sdGuard(void);
+  ~sdGuard(void);
+};
+
+// this object is used to initialize and access the contents of our SD card
+extern SdFs sd;
+
 // initialize our SdFs object
 // and perform any other operations necessary for the use of our SD card
 bool initializeSDCard(void);
@@ -42,6 +64,15 @@ void makeDirHidden(const std::string& dirName);
 bool querySD(void);
 
 // opens midi file and makes various function calls to parse the data within
+// then starts it playing. playback continues in the background
+// stopping any song that was already playing
 void openMidi(const uint8_t index);
 
+// keeps the song we're playing fed with events, closing its file once it has finished
+// this must be called regularly from our loop
+void updatePlayback(void);
+
+// stops the song we're playing, if there is one, and closes its file
+void stopPlayback(void);
+
 #endif
\ No newline at end of file
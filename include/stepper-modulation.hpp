@@ -0,0 +1,119 @@
+#ifndef STEPPER_MODULATION_HPP
+#define STEPPER_MODULATION_HPP
+#include "stepper-voiceManager.hpp"
+#include <array>
+
+// the rate in Hz at which our modulation engine recalculates the pitch
+// of every sounding note. this matches the rate at which FastAccelStepper
+// refills its queues, so no faster rate would be heard
+#define MODULATION_RATE 250
+
+// the time in uS between each update of our modulation engine
+#define MODULATION_PERIOD (1000000 / MODULATION_RATE)
+
+// the value of a centred pitch wheel
+#define PITCH_BEND_CENTER 8192
+
+// the range of our pitch wheel in cents either side of centre
+// until a channel selects another through RPN 0
+#define PITCH_BEND_RANGE_DEFAULT 200
+
+// the depth of our vibrato in cents with our mod wheel fully raised
+#define VIBRATO_DEPTH_MAX 50
+
+// the rate of our vibrato in mHz
+#define VIBRATO_RATE 5500
+
+// each step of our portamento time controller lengthens a glide by this many mS
+// so that a value of 127 glides for roughly 1.3 seconds
+#define PORTAMENTO_TIME_SCALE 10
+
+// the RPN number selected by a channel once no RPN has been selected
+// and the RPN number of our pitch bend range
+#define RPN_NULL 0x3FFF
+#define RPN_PITCH_BEND_RANGE 0x0000
+
+// this class works out the pitch of every note our steppers are playing
+// from the pitch bend, mod wheel and portamento controllers of its channel
+// pitches are held in 1/256ths of a cent, so that glides and bends
+// move smoothly no matter how slowly they change, and are only turned into
+// frequencies once per update for the notes whose pitch has actually moved
+class modulationEngine {
+  // the controllers of a single midi channel
+  struct channelState {
+    // our pitch wheel, from -8192 to 8191
+    int16_t bend = 0;
+
+    // how far our pitch wheel bends in cents either side of centre
+    uint16_t bendRange = PITCH_BEND_RANGE_DEFAULT;
+
+    // our mod wheel, which sets the depth of our vibrato
+    uint8_t modulation = 0;
+
+    // our portamento time controller, and whether portamento is switched on
+    uint8_t portamentoTime = 0;
+    bool portamento = false;
+
+    // the RPN number currently selected for data entry
+    uint16_t rpn = RPN_NULL;
+  };
+
+  // the pitch of the note played by a single stepper
+  struct voicePitch {
+    uint8_t channel = 0;
+
+    // the pitch of our note, and the pitch we are currently gliding through
+    // in 1/256ths of a cent above midi note 0
+    int32_t target = 0;
+    int32_t current = 0;
+
+    // how far our glide moves each update, 0 if we aren't gliding
+    int32_t glideStep = 0;
+
+    // the frequency in mHz last given to our stepper
+    uint32_t freq = 0;
+  };
+
+  // the controllers of each midi channel
+  std::array<channelState, MIDI_CHANNELS> channels;
+
+  // the pitch of the note played by each of our steppers
+  std::array<voicePitch, STEPPER_CHANNELS> voices;
+
+  // the phase of our vibrato, shared by every note so that they move together
+  uint32_t vibratoPhase = 0;
+
+  // returns the pitch offset of our channel's pitch wheel and vibrato
+  // in 1/256ths of a cent
+  int32_t channelOffset(const uint8_t channel) const;
+
+  // converts a pitch in 1/256ths of a cent into a frequency in mHz
+  uint32_t pitchToFreq(const int32_t pitch) const;
+
+  public:
+  modulationEngine(void);
+
+  // returns every channel's controllers to their defaults
+  void reset(void);
+
+  // starts a note on the stepper passed in, returning the frequency in mHz
+  // it should be played at. glide is true if our stepper was already playing
+  // a note, which our new note glides from if its channel has portamento on
+  uint32_t noteOn(const uint8_t stepperIdx, const uint8_t channel, const uint8_t note, const bool glide);
+
+  // applies a pitch wheel value from 0 to 16383 to our channel
+  void pitchBend(const uint8_t channel, const uint16_t value);
+
+  // applies a control change to our channel. controllers we don't use are ignored
+  void controlChange(const uint8_t channel, const uint8_t controller, const uint8_t value);
+
+  // advances our vibrato and glides by one update, then recalculates the pitch
+  // of each stepper set in activeMask. returns one bit for each stepper
+  // whose frequency has changed, which can then be read through getFreq()
+  uint32_t update(uint32_t activeMask);
+
+  // the frequency in mHz our stepper should currently be playing at
+  uint32_t getFreq(const uint8_t stepperIdx) const;
+};
+
+#endif
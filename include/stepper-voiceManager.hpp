@@ -0,0 +1,135 @@
+#ifndef STEPPER_VOICEMANAGER_HPP
+#define STEPPER_VOICEMANAGER_HPP
+#include "stepper.hpp"
+#include <array>
+
+// the number of channels a midi stream can address
+#define MIDI_CHANNELS 16
+
+// the number of notes each midi channel can address
+#define MIDI_NOTES 128
+
+// these values select how our voice manager chooses a note to cut off
+// when a new note arrives while every one of our steppers is busy
+// the new note is dropped
+#define VOICE_STEAL_NONE 0
+
+// the note that started longest ago is cut off
+#define VOICE_STEAL_OLDEST 1
+
+// the note struck with the lowest velocity is cut off, the oldest of those if tied
+#define VOICE_STEAL_QUIETEST 2
+
+// the oldest note on the new note's own channel is cut off
+// or the oldest note of any channel if its channel has no notes sounding
+#define VOICE_STEAL_SAME_CHANNEL 3
+
+// the oldest note is cut off, but never the highest note sounding
+// so that the melody of a dense chord is kept
+#define VOICE_STEAL_KEEP_HIGHEST 4
+
+// the number of policies above
+#define VOICE_STEAL_POLICIES 5
+
+// the policy our voice manager starts out with
+#define VOICE_STEAL_DEFAULT VOICE_STEAL_SAME_CHANNEL
+
+// our stepper masks hold one bit per stepper
+static_assert(STEPPER_CHANNELS <= 32, "stepper masks can only hold 32 steppers");
+
+// this class decides which of our steppers plays each note
+// every lookup is made through bitmasks and tables rather than
+// by searching our steppers, so allocating and releasing a voice
+// costs the same no matter how many steppers are attached
+class voiceManager {
+  // the note and channel currently played by a single stepper
+  // along with what we need to know to choose which note to steal
+  struct voice {
+    uint8_t channel = NO_CHANNEL;
+    uint8_t note = 0;
+    uint8_t velocity = 0;
+
+    // taken from our noteCount when our note started. lower values are older
+    uint32_t age = 0;
+  };
+
+  // the note and channel played by each of our steppers
+  std::array<voice, STEPPER_CHANNELS> voices;
+
+  // one bit for each stepper that we're able to play notes on
+  uint32_t availableMask = 0;
+
+  // one bit for each stepper that isn't playing a note
+  uint32_t freeMask = 0;
+
+  // one bit for each stepper playing a note on each channel
+  std::array<uint32_t, MIDI_CHANNELS> channelMasks;
+
+  // the stepper playing each note of each channel, or NOT_FOUND
+  std::array<std::array<uint8_t, MIDI_NOTES>, MIDI_CHANNELS> noteMap;
+
+  // counts every note given a stepper, so that we know which notes are oldest
+  uint32_t noteCount = 0;
+
+  // one of the VOICE_STEAL_ values defined above
+  uint8_t policy = VOICE_STEAL_DEFAULT;
+
+  // the number of notes stolen and dropped under each of our policies
+  std::array<uint32_t, VOICE_STEAL_POLICIES> steals;
+  std::array<uint32_t, VOICE_STEAL_POLICIES> drops;
+
+  // returns the lowest stepper set in the mask passed in, or NOT_FOUND if it is empty
+  static uint8_t firstStepper(const uint32_t mask);
+
+  // gives the stepper passed in our note, taking it from whatever it was playing
+  void assign(const uint8_t stepperIdx, const uint8_t channel, const uint8_t note, const uint8_t velocity);
+
+  // returns the oldest stepper set in the mask passed in, or NOT_FOUND if it is empty
+  uint8_t oldestStepper(uint32_t mask) const;
+
+  // chooses a busy stepper to cut off for our new note under our current policy
+  // returns NOT_FOUND if our policy is to drop our new note instead
+  // this is the only part of our voice manager that looks at every stepper
+  // but it is only needed once every stepper is already busy
+  uint8_t chooseVictim(const uint8_t channel) const;
+
+  public:
+  voiceManager(void);
+
+  // frees every one of our steppers. our counters are kept
+  void reset(void);
+
+  // limits our voice manager to the steppers set in the mask passed in
+  // for when some of our steppers couldn't be connected. frees every stepper
+  void setAvailable(const uint32_t mask);
+
+  // chooses a stepper to play our note on, returning its index
+  // or NOT_FOUND if our note was dropped. a note already sounding
+  // keeps its stepper. polyphonic channels prefer a free stepper, whereas
+  // monophonic channels prefer to take over their own stepper, only using
+  // a free stepper when they have none. once every stepper is busy
+  // a note is stolen according to our policy
+  uint8_t noteOn(const uint8_t channel, const uint8_t note, const uint8_t velocity, const bool polyphonic);
+
+  // frees the stepper playing our note, returning its index
+  // or NOT_FOUND if our note isn't being played
+  uint8_t noteOff(const uint8_t channel, const uint8_t note);
+
+  // frees the stepper passed in, whichever note it is playing, returning its index
+  // or NOT_FOUND if it wasn't playing a note
+  uint8_t release(const uint8_t stepperIdx);
+
+  // returns one bit for each stepper currently playing a note
+  uint32_t activeMask(void) const;
+
+  // selects one of the VOICE_STEAL_ policies defined above
+  void setPolicy(const uint8_t policy);
+  uint8_t getPolicy(void) const;
+
+  // the number of notes stolen and dropped under each of our policies
+  // indexed by policy, since our voice manager was created
+  const std::array<uint32_t, VOICE_STEAL_POLICIES>& getSteals(void) const;
+  const std::array<uint32_t, VOICE_STEAL_POLICIES>& getDrops(void) const;
+};
+
+#endif
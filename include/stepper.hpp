@@ -8,18 +8,77 @@
 // for our ESP32
 #define STEPPER_CHANNELS 4
 
+// our ESP32 can drive 6 steppers through its MCPWM and PCNT peripherals
+// and a further 8 through its RMT peripheral, for 14 in total
+#define STEPPER_CHANNELS_MAX 14
+static_assert(STEPPER_CHANNELS <= STEPPER_CHANNELS_MAX, "our ESP32 can drive at most 14 steppers");
+
+// these values describe which of our ESP32's peripherals drives each stepper
+// steppers are given to our MCPWM/PCNT driver first, then to our RMT driver
+// once it runs out. steppers that couldn't be connected at all have no driver
+#define STEPPER_DRIVER_NONE 0
+#define STEPPER_DRIVER_MCPWM_PCNT 1
+#define STEPPER_DRIVER_RMT 2
+
 #define NO_CHANNEL 255
 #define NOT_FOUND 255
 
 // this function initializes our stepper motor object and sets default parameters
+// connecting a stepper to each of our MTR_STEPS pins and reporting the driver
+// each was given. steppers that fail to connect are left out of our voice manager
 void initializeStepper(void);
 
-// this function takes in our deltaTime in microseconds,
-// note as frequency in millihertz, and event as an 8 bit integer
-// and plays a note at the given frequency
-// the deltaTime provided dictates the duration of the previously provided
-// note; upon calling this function, the note passed in will continue
+// returns one of the STEPPER_DRIVER_ values above for the stepper passed in
+uint8_t getStepperDriver(const uint8_t stepperIdx);
+
+// this function takes in our midi note number, and event as an 8 bit integer
+// and plays our note on whichever stepper our voice manager chooses
+// the event is applied immediately, so it must only be called once the event is due
+// upon calling this function, the note passed in will continue
 // to sound until a note off event occurs or a new frequency is provided
-void playNote(const uint32_t deltaTime, const uint32_t note, const uint8_t event, const bool polyphonic, std::stringstream& debugString);
+// velocity is used to choose which note to steal when every stepper is busy
+// returns the index of the stepper our note was played on, or NOT_FOUND
+uint8_t playNote(const uint8_t note, const uint8_t velocity, const uint8_t event, const bool polyphonic);
+
+// returns true if the stepper passed in has been given a note that is waiting
+// to be started by our stepper task, rather than already stepping
+bool isNoteStarting(const uint8_t stepperIdx);
+
+// applies a pitch wheel value from 0 to 16383 to the channel passed in
+// bending every note sounding on it from our next modulation update onwards
+void pitchBend(const uint8_t channel, const uint16_t value);
+
+// applies a control change to the channel passed in
+// only our mod wheel, portamento and pitch bend range controllers have any effect
+void controlChange(const uint8_t channel, const uint8_t controller, const uint8_t value);
+
+// moves the pitch of every sounding note along its bend, vibrato and glide
+// retuning our steppers without restarting them. this must be called
+// every MODULATION_PERIOD uS from the same task that plays our notes
+void updateModulation(void);
+
+// returns every channel's pitch bend, modulation and portamento to their defaults
+// used before a new song starts playing, from the same task that plays our notes
+void resetControllers(void);
+
+// notes played between these two calls are started together
+// by our stepper task, rather than one after another as they are played
+// every note sharing a timestamp should be played within one batch
+void beginNoteBatch(void);
+void commitNoteBatch(void);
+
+// stops every stepper that is currently playing a note
+// used when a song is stopped before it has finished
+// this must be called from the same task that plays our notes
+void silenceSteppers(void);
+
+// selects how notes are stolen once every stepper is busy
+// takes one of the VOICE_STEAL_ values defined in stepper-voiceManager.hpp
+void setStealPolicy(const uint8_t policy);
+
+// this is a debug function used to print the number of notes
+// stolen and dropped under each of our voice stealing policies
+// along with the worst skew measured between notes started together
+void printVoiceStats(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef UART_LATENCY_HPP
+#define UART_LATENCY_HPP
+#include "globals.hpp"
+#include "stepper.hpp"
+#include <array>
+
+// when true, the time every live note takes from arriving over our UART
+// to being started on a stepper is measured and can be printed on demand
+// it follows SERIAL_DEBUG, so release builds carry none of it
+#define LATENCY_PROFILE SERIAL_DEBUG
+
+// the width in uS of each bucket of our latency histograms, and the number
+// of buckets each holds. our last bucket also holds anything slower than it
+#define LATENCY_BUCKET_WIDTH 25
+#define LATENCY_BUCKETS 128
+
+// the stages of a live note we measure the latency of, each from the moment
+// its last byte arrived over our UART
+// LATENCY_ALLOCATE ends once our voice manager has chosen its stepper
+// LATENCY_COMMIT ends once FastAccelStepper has started that stepper's queue
+#define LATENCY_ALLOCATE 0
+#define LATENCY_COMMIT 1
+#define LATENCY_STAGES 2
+
+// the characters typed into our serial monitor to print or clear our histograms
+#define LATENCY_PRINT_COMMAND 'l'
+#define LATENCY_CLEAR_COMMAND 'c'
+
+#if LATENCY_PROFILE
+// this class records the latencies of a single stage in fixed memory
+// it may only be recorded to from a single task
+class latencyHistogram {
+  // the number of latencies that have fallen within each bucket
+  std::array<uint32_t, LATENCY_BUCKETS> buckets;
+
+  // the number of latencies recorded, along with their sum
+  // and the fastest and slowest of them, in uS
+  uint32_t count = 0;
+  uint64_t total = 0;
+  uint32_t fastest = UINT32_MAX;
+  uint32_t slowest = 0;
+
+  // set by clear() and acted on by our recording task at its next record()
+  // so that our histogram is never cleared part way through a record
+  std::atomic<bool> clearPending { false };
+
+  public:
+  latencyHistogram(void);
+
+  // adds the latency in uS passed in to our histogram
+  void record(const uint32_t latency);
+
+  // empties our histogram before its next latency is recorded
+  void clear(void);
+
+  // prints our count, min, avg, p99 and max latencies to our serial monitor
+  // our p99 is the upper edge of the bucket it falls within
+  void print(const char* name) const;
+};
+
+// records the allocation of a live note to the stepper passed in
+// received is the time its message arrived, from our UART's event task
+// starting is true if our stepper's queue is waiting to be started for it
+// rather than already stepping, in which case its commit is measured too
+void latencyAllocated(const uint8_t stepperIdx, const uint32_t received, const bool starting);
+
+// records that the queue of the stepper passed in has been started
+// this is called from FastAccelStepper's task
+void latencyStarted(const uint8_t stepperIdx);
+
+// prints or clears our histograms if the command typed into our serial monitor asks us to
+void handleLatencyCommand(const char command);
+#else
+inline void latencyAllocated(const uint8_t stepperIdx, const uint32_t received, const bool starting) {}
+inline void latencyStarted(const uint8_t stepperIdx) {}
+inline void handleLatencyCommand(const char command) {}
+#endif
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef UART_MIDIPARSER_HPP
+#define UART_MIDIPARSER_HPP
+#include <cstdint>
+
+// the status bytes that start and end a system exclusive message
+// every data byte between them is skipped
+#define MIDI_SYSEX_START 0xF0
+#define MIDI_SYSEX_END 0xF7
+
+// the lowest of our system realtime status bytes, 0xF8 to 0xFF
+// these are a single byte long and may arrive between the bytes of any other message
+#define MIDI_REALTIME 0xF8
+
+// system common messages and their data bytes
+// these cancel running status, so the channel messages after them must resend theirs
+#define MIDI_TIME_CODE 0xF1
+#define MIDI_SONG_POSITION 0xF2
+#define MIDI_SONG_SELECT 0xF3
+#define MIDI_TUNE_REQUEST 0xF6
+
+// this struct describes a single complete midi message received over our UART
+// messages with fewer than two data bytes leave the rest as 0
+struct liveMessage {
+  // the status byte of our message, holding both its type and channel
+  uint8_t status;
+
+  // the data bytes of our message, such as the note and velocity of a note on
+  uint8_t data1;
+  uint8_t data2;
+
+  // the time in uS our message's last byte arrived according to esp_timer_get_time()
+  // left for whoever receives our message to fill in
+  uint32_t timestamp;
+};
+
+// this class turns the bytes of a live midi stream into complete messages
+// one byte at a time, so that it can be fed straight from our UART as bytes arrive
+// running status is followed, so a channel message may leave out its status byte
+// whenever it matches the message before it
+// realtime bytes are passed on as soon as they arrive, even part way through
+// another message, and system exclusive messages are skipped entirely
+class midiParser {
+  // the status of the message we are reading, which is kept once our message is
+  // complete for any data bytes that follow under running status
+  // 0 while no status is in effect, in which case stray data bytes are ignored
+  uint8_t status = 0;
+
+  // the number of data bytes our status calls for
+  uint8_t dataNeeded = 0;
+
+  // the data bytes of our message read so far
+  uint8_t data[2] = { 0, 0 };
+  uint8_t dataCount = 0;
+
+  // true while we are skipping over a system exclusive message
+  bool sysex = false;
+
+  public:
+  // takes the next byte of our stream, storing the message it completes in message
+  // returns true if a message was completed, otherwise message is left untouched
+  bool parse(const uint8_t byte, liveMessage& message);
+
+  // forgets any message part way through being read along with our running status
+  void reset(void);
+};
+
+#endif
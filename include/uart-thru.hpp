@@ -0,0 +1,46 @@
+#ifndef UART_THRU_HPP
+#define UART_THRU_HPP
+#include "globals.hpp"
+
+// the size in bytes of the buffer our UART driver sends our thru messages from
+// our messages are copied into it and sent by our driver in the background
+// so our playback task never waits on our wire. it must be larger than
+// our UART's 128 byte FIFO, and holds roughly 80mS of a saturated wire
+#define UART_THRU_BUFFER 256
+
+// when true, note offs are sent as note ons with a velocity of 0
+// so that they share running status with the note ons around them
+// at the cost of their release velocity, which our steppers never use
+#define UART_THRU_NOTE_OFF_AS_ON true
+
+// if nothing has been sent for this many uS, our next message resends its status
+// so that a device connected part way through a song picks up our running status
+// our wire is idle at that point, so the extra byte costs us nothing
+#define UART_THRU_STATUS_REFRESH 100000
+
+// the number of bytes our wire can carry per second at our baud rate
+// each byte takes a start and stop bit along with its 8 data bits
+#define UART_THRU_BYTES_PER_SECOND (UART_BAUD / 10)
+
+// sets up our UART's transmit buffer, must be called before our UART is started
+void initializeThru(void);
+
+// echoes a message out of our UART, leaving out its status byte under running status
+// system realtime messages are a single byte, and leave our running status alone
+// system common messages are sent with their data bytes, and cancel our running status
+// a message that won't fit in our transmit buffer is dropped whole and counted
+// this must only be called from our playback task
+void sendThru(uint8_t status, const uint8_t data1, uint8_t data2);
+
+// sends all notes off on every channel set in the mask passed in
+// so that devices following our song don't hold on to its notes once it is stopped
+void silenceThru(const uint16_t channels);
+
+// starts our throughput measurements over, called as each song starts playing
+void resetThruStats(void);
+
+// prints the messages and bytes we have sent, what running status saved us,
+// what we dropped and our throughput since our measurements were last reset
+void printThruStats(void);
+
+#endif
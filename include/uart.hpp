@@ -1,8 +1,22 @@
 #ifndef UART_HPP
 #define UART_HPP
 #include "globals.hpp"
+#include "uart-midiParser.hpp"
 
+// the number of live messages that can wait to be played at once
+// messages received while our queue is full are dropped
+// this must be a power of two
+#define UART_LIVE_QUEUE 64
+
+// starts our UART and has every midi message it receives played on our steppers
+// and recorded whenever our recorder is running
+// bytes are handed to our parser as soon as they arrive, and each complete
+// message is queued for our playback task, which is woken straight away
 void initializeUART();
-void checkMIDI();
 
-#endif
\ No newline at end of file
+// takes the next live message waiting to be played, storing it in message
+// returns false once no messages are waiting
+// this must only be called from our playback task
+bool popLiveMessage(liveMessage& message);
+
+#endif
@@ -21,6 +21,12 @@ FastAccelStepper fas_stepper[MAX_STEPPER];
 void FastAccelStepperEngine::init() {
   _externalCallForPin = NULL;
   _stepper_cnt = 0;
+  _tone_batch_open = false;
+  _tone_start_requested = false;
+  _tone_start_callback = NULL;
+#if defined(SUPPORT_CYCLE_COUNT)
+  _max_tone_start_skew = 0;
+#endif
   fas_init_engine(this, 255);
   for (uint8_t i = 0; i < MAX_STEPPER; i++) {
     _stepper[i] = NULL;
@@ -31,6 +37,12 @@ void FastAccelStepperEngine::init() {
 void FastAccelStepperEngine::init(uint8_t cpu_core) {
   _externalCallForPin = NULL;
   _stepper_cnt = 0;
+  _tone_batch_open = false;
+  _tone_start_requested = false;
+  _tone_start_callback = NULL;
+#if defined(SUPPORT_CYCLE_COUNT)
+  _max_tone_start_skew = 0;
+#endif
   fas_init_engine(this, cpu_core);
 }
 #endif
@@ -152,6 +164,7 @@ void FastAccelStepperEngine::manageSteppers() {
 #endif
     }
   }
+  startPendingTones();
 
   // Check for auto disable
   for (uint8_t i = 0; i < MAX_STEPPER; i++) {
@@ -207,6 +220,63 @@ void FastAccelStepperEngine::manageSteppers() {
   }
 }
 
+void FastAccelStepperEngine::beginToneBatch() { _tone_batch_open = true; }
+void FastAccelStepperEngine::commitToneBatch() {
+  _tone_batch_open = false;
+  if (_tone_start_requested) {
+    _tone_start_requested = false;
+    wakeForToneStart();
+  }
+}
+
+void FastAccelStepperEngine::requestToneStart() {
+  if (_tone_batch_open) {
+    // started on commitToneBatch() together with the rest of the batch
+    _tone_start_requested = true;
+  } else {
+    wakeForToneStart();
+  }
+}
+
+void FastAccelStepperEngine::wakeForToneStart() {
+#if defined(SUPPORT_TASK_WAKEUP)
+  fas_wake_engine();
+#endif
+}
+
+void FastAccelStepperEngine::startPendingTones() {
+  // All queues are already filled, so the tones are started back to back
+#if defined(SUPPORT_CYCLE_COUNT)
+  uint32_t first_start = 0;
+  bool started = false;
+#endif
+  bool started_now[MAX_STEPPER];
+  for (uint8_t i = 0; i < MAX_STEPPER; i++) {
+    FastAccelStepper* s = _stepper[i];
+    started_now[i] = s && s->_tone_start_pending;
+    if (started_now[i]) {
+      s->_tone_start_pending = false;
+#if defined(SUPPORT_CYCLE_COUNT)
+      uint32_t now = fas_cycle_count();
+      if (!started) {
+        first_start = now;
+        started = true;
+      }
+      _max_tone_start_skew = fas_max(_max_tone_start_skew, now - first_start);
+#endif
+      s->addQueueEntry(NULL, true);
+    }
+  }
+  // Reported only once every tone is running, so the callback adds no skew
+  if (_tone_start_callback != NULL) {
+    for (uint8_t i = 0; i < MAX_STEPPER; i++) {
+      if (started_now[i]) {
+        _tone_start_callback(_stepper[i]);
+      }
+    }
+  }
+}
+
 //*************************************************************************************************
 //*************************************************************************************************
 //
@@ -358,6 +428,11 @@ bool FastAccelStepper::externalDirPinChangeCompletedIfNeeded() {
 //*************************************************************************************************
 
 void FastAccelStepper::fill_queue() {
+  // In tone mode the ramp generator is bypassed
+  if (_tone_ticks != 0) {
+    fill_tone_queue();
+    return;
+  }
   // Check preconditions to be allowed to fill the queue
   if (!_rg.isRampGeneratorActive()) {
     return;
@@ -444,6 +519,101 @@ void FastAccelStepper::fill_queue() {
   }
 }
 
+//*************************************************************************************************
+// fill_tone_queue generates commands with a constant period for tone mode
+//
+// Periods up to 65535 ticks are added as commands of approx.
+// TONE_ENTRY_TICKS, but at least MIN_CMD_TICKS. Longer periods are split into
+// one step followed by pauses, all of nearly equal length. The queue is only
+// filled TONE_LOOKAHEAD_TICKS ahead, so a new period is not delayed by a
+// long queue.
+//
+//*************************************************************************************************
+
+void FastAccelStepper::fill_tone_queue() {
+  StepperQueue* q = &fas_queue[_queue_num];
+  // a tone has been started after forceStop(), so commands are accepted again
+  q->ignore_commands = false;
+
+  uint32_t period = _tone_ticks;
+  bool delayed_start = !q->isRunning();
+  if (delayed_start && (_engine != NULL) && _engine->_tone_batch_open) {
+    // wait for the batch to be committed and start together with the others
+    return;
+  }
+  bool need_delayed_start = false;
+  uint32_t ticksPrepared = q->ticksInQueue();
+  while (ticksPrepared < TONE_LOOKAHEAD_TICKS) {
+    int8_t res = AQE_OK;
+    if (period <= 65535) {
+      if (isQueueFull()) {
+        break;
+      }
+      uint32_t steps = fas_max(TONE_ENTRY_TICKS / period,
+                               (MIN_CMD_TICKS + period - 1) / period);
+      steps = fas_min(steps, (uint32_t)255);
+      struct stepper_command_s cmd = {
+          .ticks = (uint16_t)period, .steps = (uint8_t)steps, .count_up = true};
+      res = addQueueEntry(&cmd, !delayed_start);
+      if (res == AQE_OK) {
+        ticksPrepared += period * steps;
+      }
+    } else {
+      uint8_t parts = (period + 65534) / 65535;
+      if (QUEUE_LEN - q->queueEntries() < parts) {
+        break;
+      }
+      uint32_t remaining = period;
+      for (uint8_t i = parts; (i > 0) && (res == AQE_OK); i--) {
+        uint16_t ticks = remaining / i;
+        struct stepper_command_s cmd = {.ticks = ticks,
+                                        .steps = (uint8_t)(i == parts),
+                                        .count_up = true};
+        res = addQueueEntry(&cmd, !delayed_start);
+        remaining -= ticks;
+      }
+      if (res == AQE_OK) {
+        ticksPrepared += period;
+      }
+    }
+    if (res != AQE_OK) {
+      if (res < 0) {
+        // the tone cannot be played at all
+        _tone_ticks = 0;
+      }
+      break;
+    }
+    need_delayed_start = delayed_start;
+  }
+  if (need_delayed_start) {
+    // the engine starts all new tones together after filling every queue
+    _tone_start_pending = true;
+  }
+}
+
+int8_t FastAccelStepper::setToneInMilliHz(uint32_t freq_mhz) {
+  if (_rg.isRampGeneratorActive()) {
+    return TONE_ERR_RAMP_IS_ACTIVE;
+  }
+  if (freq_mhz == 0) {
+    return TONE_ERR_FREQUENCY_TOO_LOW;
+  }
+  uint64_t ticks = ((uint64_t)TICKS_PER_S * 1000 + freq_mhz / 2) / freq_mhz;
+  if (ticks < fas_queue[_queue_num].getMaxSpeedInTicks()) {
+    return TONE_ERR_FREQUENCY_TOO_HIGH;
+  }
+  if (ticks > TONE_MAX_PERIOD_TICKS) {
+    return TONE_ERR_FREQUENCY_TOO_LOW;
+  }
+  _tone_ticks = ticks;
+  if ((_engine != NULL) && !fas_queue[_queue_num].isRunning()) {
+    _engine->requestToneStart();
+  }
+  return TONE_OK;
+}
+
+void FastAccelStepper::stopTone() { _tone_ticks = 0; }
+
 void FastAccelStepper::updateAutoDisable() {
   // FastAccelStepperEngine will call with interrupts disabled
   // fasDisableInterrupts();
@@ -508,6 +678,8 @@ void FastAccelStepper::init(FastAccelStepperEngine* engine, uint8_t num,
   _dirPin = PIN_UNDEFINED;
   _enablePinHighActive = PIN_UNDEFINED;
   _enablePinLowActive = PIN_UNDEFINED;
+  _tone_ticks = 0;
+  _tone_start_pending = false;
   _rg.init();
 
   _queue_num = num;
@@ -661,6 +833,7 @@ void FastAccelStepper::forceStop() {
 
   // ensure no more commands are added to the queue
   q->ignore_commands = true;
+  _tone_ticks = 0;
 
   // inform ramp generator to force stop
   _rg.forceStop();
@@ -670,6 +843,7 @@ void FastAccelStepper::forceStopAndNewPosition(uint32_t new_pos) {
 
   // ensure no more commands are added to the queue
   q->ignore_commands = true;
+  _tone_ticks = 0;
 
   // stop ramp generator
   _rg.stopRamp();
@@ -879,7 +1053,8 @@ bool FastAccelStepper::isQueueRunning() {
 }
 bool FastAccelStepper::isRunning() {
   StepperQueue* q = &fas_queue[_queue_num];
-  return q->isRunning() || _rg.isRampGeneratorActive() || !isQueueEmpty();
+  return q->isRunning() || _rg.isRampGeneratorActive() || !isQueueEmpty() ||
+         (_tone_ticks != 0);
 }
 void FastAccelStepper::performOneStep(bool count_up, bool blocking) {
   if (!isRunning()) {
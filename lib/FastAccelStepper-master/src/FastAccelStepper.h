@@ -139,11 +139,53 @@ class FastAccelStepperEngine {
   // the engine. The periodic task will let the associated LED blink with 1 Hz
   void setDebugLed(uint8_t ledPin);
 
+  // ### Simultaneous tone starts
+  //
+  // Tones started with setToneInMilliHz() on steppers, which are not running,
+  // are started by the stepper task. The queues of all tones to be started in
+  // the same run of the stepper task are filled first and then started back
+  // to back.
+  //
+  // In order to start several tones together, wrap their setToneInMilliHz()
+  // calls in beginToneBatch() and commitToneBatch(). While a batch is open, no
+  // new tone is started. This is only reliable, if the stepper task runs on
+  // the same core as the caller, see init(cpu_core).
+  //
+  // If supported by the platform, the stepper task is woken as soon as a new
+  // tone can be started, instead of waiting up to DELAY_MS_BASE for its next
+  // cyclic run.
+  void beginToneBatch();
+  void commitToneBatch();
+
+  // A callback can be supplied, which is called from the stepper task right
+  // after the queue of a new tone has been started. It should return quickly,
+  // as it delays the start of any other tone in the same run.
+  void setToneStartCallback(void (*func)(FastAccelStepper* stepper)) {
+    _tone_start_callback = func;
+  }
+
+#if defined(SUPPORT_CYCLE_COUNT)
+  // The largest skew between the first and the last tone started in one run
+  // of the stepper task in cpu cycles. This can be reset to 0.
+  uint32_t getMaxToneStartSkewInCycles() { return _max_tone_start_skew; }
+  void resetMaxToneStartSkew() { _max_tone_start_skew = 0; }
+#endif
+
   /* This should be only called from ISR or stepper task. So do not call it */
   void manageSteppers();
 
  private:
   bool isDirPinBusy(uint8_t dirPin, uint8_t except_stepper);
+  void startPendingTones();
+  void requestToneStart();
+  void wakeForToneStart();
+
+  volatile bool _tone_batch_open;
+  volatile bool _tone_start_requested;
+  void (*_tone_start_callback)(FastAccelStepper* stepper);
+#if defined(SUPPORT_CYCLE_COUNT)
+  uint32_t _max_tone_start_skew;
+#endif
 
   uint8_t _stepper_cnt;
   FastAccelStepper* _stepper[MAX_STEPPER];
@@ -225,6 +267,18 @@ class FastAccelStepperEngine {
 
 #define MAX_ON_DELAY_TICKS ((uint32_t)(65535 * (QUEUE_LEN - 1)))
 
+// In tone mode, every queue entry lasts approx. TONE_ENTRY_TICKS and the
+// queue is kept filled TONE_LOOKAHEAD_TICKS in advance, which covers two
+// runs of the stepper task. The longest tone period has to fit into the queue.
+#define TONE_ENTRY_TICKS (TICKS_PER_S / 1000)
+#define TONE_LOOKAHEAD_TICKS (2 * DELAY_MS_BASE * (TICKS_PER_S / 1000))
+#define TONE_MAX_PERIOD_TICKS MAX_ON_DELAY_TICKS
+
+#define TONE_OK 0
+#define TONE_ERR_RAMP_IS_ACTIVE -1
+#define TONE_ERR_FREQUENCY_TOO_HIGH -2
+#define TONE_ERR_FREQUENCY_TOO_LOW -3
+
 #define PIN_UNDEFINED 255
 #define PIN_EXTERNAL_FLAG 128
 
@@ -526,6 +580,22 @@ class FastAccelStepper {
   // provided and will be set as current position after stop.
   void forceStopAndNewPosition(uint32_t new_pos);
 
+  // ## Tone mode
+  // setToneInMilliHz() lets the stepper step forward continuously at exactly
+  // the frequency given in mHz. The ramp generator is bypassed: the period is
+  // converted once into ticks and the queue is filled by the stepper task with
+  // constant period commands. Periods above 65535 ticks are split into one
+  // step and pauses. A frequency change takes effect with the next queue entry
+  // to be filled, so after at most TONE_LOOKAHEAD_TICKS.
+  //
+  // Tone mode cannot be started while the ramp generator is active.
+  // stopTone() stops adding commands and the queue runs empty.
+  // forceStop() and forceStopAndNewPosition() end tone mode, too.
+  // return values are the TONE_... constants
+  int8_t setToneInMilliHz(uint32_t freq_mhz);
+  void stopTone();
+  inline bool isToneActive() { return _tone_ticks != 0; }
+
   // get the target position for the current move.
   // As of now, this position is the view of the stepper task.
   // This means, the value will stay unchanged after a move/moveTo until the
@@ -662,6 +732,7 @@ class FastAccelStepper {
   bool externalDirPinChangeCompletedIfNeeded();
 #endif
   void fill_queue();
+  void fill_tone_queue();
   void updateAutoDisable();
   void blockingWaitForForceStopComplete();
   bool needAutoDisable();
@@ -684,6 +755,11 @@ class FastAccelStepper {
   uint16_t _off_delay_count;
   uint16_t _auto_disable_delay_counter;
 
+  // period of the tone in ticks, or 0 if tone mode is not active
+  volatile uint32_t _tone_ticks;
+  // queue has been filled for a tone and waits to be started by the engine
+  bool _tone_start_pending;
+
 #if defined(SUPPORT_ESP32_PULSE_COUNTER)
   int16_t _attached_pulse_cnt_unit;
 #endif
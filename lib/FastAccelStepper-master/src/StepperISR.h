@@ -190,3 +190,6 @@ class StepperQueue {
 extern StepperQueue fas_queue[NUM_QUEUES];
 
 void fas_init_engine(FastAccelStepperEngine* engine, uint8_t cpu_core);
+#if defined(SUPPORT_TASK_WAKEUP)
+void fas_wake_engine();
+#endif
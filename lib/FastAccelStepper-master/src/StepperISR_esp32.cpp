@@ -110,6 +110,8 @@ bool StepperQueue::isValidStepPin(uint8_t step_pin) {
 int8_t StepperQueue::queueNumForStepPin(uint8_t step_pin) { return -1; }
 
 //*************************************************************************************************
+static TaskHandle_t fas_stepper_task = NULL;
+
 void StepperTask(void *parameter) {
   FastAccelStepperEngine *engine = (FastAccelStepperEngine *)parameter;
   const TickType_t delay_4ms =
@@ -117,10 +119,23 @@ void StepperTask(void *parameter) {
   while (true) {
     engine->manageSteppers();
     esp_task_wdt_reset();
+#if defined(SUPPORT_TASK_WAKEUP)
+    // fas_wake_engine() ends the wait early
+    ulTaskNotifyTake(pdTRUE, delay_4ms);
+#else
     vTaskDelay(delay_4ms);
+#endif
   }
 }
 
+#if defined(SUPPORT_TASK_WAKEUP)
+void fas_wake_engine() {
+  if (fas_stepper_task != NULL) {
+    xTaskNotifyGive(fas_stepper_task);
+  }
+}
+#endif
+
 void StepperQueue::adjustSpeedToStepperCount(uint8_t steppers) {
   max_speed_in_ticks = 80;  // This equals 200kHz @ 16MHz
 }
@@ -133,10 +148,11 @@ void fas_init_engine(FastAccelStepperEngine *engine, uint8_t cpu_core) {
 #define STACK_SIZE 2000
 #define PRIORITY configMAX_PRIORITIES
   if (cpu_core > 1) {
-    xTaskCreate(StepperTask, "StepperTask", STACK_SIZE, engine, PRIORITY, NULL);
+    xTaskCreate(StepperTask, "StepperTask", STACK_SIZE, engine, PRIORITY,
+                &fas_stepper_task);
   } else {
     xTaskCreatePinnedToCore(StepperTask, "StepperTask", STACK_SIZE, engine,
-                            PRIORITY, NULL, cpu_core);
+                            PRIORITY, &fas_stepper_task, cpu_core);
   }
 }
 
@@ -237,6 +237,13 @@ struct queue_end_s {
 // have more than one core
 #define SUPPORT_CPU_AFFINITY
 
+// cpu cycle counter for timing measurements
+#define SUPPORT_CYCLE_COUNT
+#define fas_cycle_count() ESP.getCycleCount()
+
+// the stepper task can be woken before its next cyclic run
+#define SUPPORT_TASK_WAKEUP
+
 //==========================================================================
 //
 // This for ESP32 derivates using espidf
@@ -1,10 +1,13 @@
 #include "display.hpp"
 #include "globals.hpp"
 #include "midi.hpp"
+#include "midi-trace.hpp"
 #include "oled.hpp"
 #include "rotary.hpp"
 #include "sdio.hpp"
+#include "sdio-recorder.hpp"
 #include "stepper.hpp"
+#include "uart-latency.hpp"
 #include "uart.hpp"
 
 void setup() {
@@ -39,10 +42,26 @@ void loop() {
   // if we have navigated to a different page
   refreshDisplay();
 
+  // keep our song fed with events while it plays in the background
+  // and print out what it has played so far
+  updatePlayback();
+  drainTrace();
+
+  // carry out any commands typed into our serial monitor, such as
+  // printing our live latency histograms or starting and stopping a recording
+  while (SERIAL_DEBUG && Serial.available()) {
+    const char command = Serial.read();
+    handleLatencyCommand(command);
+    handleRecordCommand(command);
+  }
+
   // check if sd card is removed after initialization
   if (!querySD()) {
     // if sd card was removed, update indicator to reflect sd card status
+    // and stop any song being played from it or recording being made to it
     sdInitStatus(false);
+    stopPlayback();
+    recorder.stop();
 
     // attempt to reinitialize sd card
     while (!initializeSDCard()) {
@@ -54,6 +73,4 @@ void loop() {
     // once reinitialization of sd card succeeds, update indicator
     sdInitStatus(true);
   }
-
-  //checkMIDI();
 }
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "midi-byteSource.hpp"
+#include <algorithm>
+
+void queueByteSource::loadFile(FsFile& file) {
+  while (file.peek() != -1) {
+    this->byteArray.push((uint8_t)file.read());
+  }
+  return;
+}
+
+uint32_t queueByteSource::available(void) {
+  return this->byteArray.size();
+}
+
+uint8_t queueByteSource::peek(void) {
+  return this->byteArray.empty() ? 0 : this->byteArray.front();
+}
+
+uint8_t queueByteSource::read(void) {
+  if (this->byteArray.empty()) {
+    return 0;
+  }
+  uint8_t byte = this->byteArray.front();
+  this->byteArray.pop();
+  return byte;
+}
+
+fileByteSource::fileByteSource(FsFile* file, const uint16_t blockSize) : fileByteSource(file, file->curPosition(), file->fileSize() - file->curPosition(), blockSize) {
+}
+
+fileByteSource::fileByteSource(FsFile* file, const uint64_t start, const uint32_t length, const uint16_t blockSize) : file(file), position(start), unread(length), block(blockSize) {
+}
+
+bool fileByteSource::refill(void) {
+  if (this->unread == 0) {
+    return false;
+  }
+
+  // another source may have moved our file's position since our last read
+  if (this->file->curPosition() != this->position && !this->file->seekSet(this->position)) {
+    this->unread = 0;
+    return false;
+  }
+
+  // never request more than is left in our file, and
+  // treat a failed read as the end of our file so that
+  // a bad card can't leave our parser reading forever
+  int bytesRead = this->file->read(this->block.data(), std::min<uint32_t>(this->unread, this->block.size()));
+  if (bytesRead <= 0) {
+    this->unread = 0;
+    return false;
+  }
+  this->position += bytesRead;
+  this->unread -= bytesRead;
+  this->blockLen = bytesRead;
+  this->blockIdx = 0;
+  return true;
+}
+
+uint32_t fileByteSource::available(void) {
+  return this->unread + (this->blockLen - this->blockIdx);
+}
+
+uint8_t fileByteSource::peek(void) {
+  if (this->blockIdx >= this->blockLen && !refill()) {
+    return 0;
+  }
+  return this->block[this->blockIdx];
+}
+
+uint8_t fileByteSource::read(void) {
+  if (this->blockIdx >= this->blockLen && !refill()) {
+    return 0;
+  }
+  return this->block[this->blockIdx++];
+}
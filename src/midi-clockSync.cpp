@@ -0,0 +1,88 @@
+#include "midi-clockSync.hpp"
+#include <cstdlib>
+
+void clockSync::clock(const int64_t arrival) {
+  // after a long enough gap, the time since our last clock
+  // tells us nothing about our master's tempo
+  if (this->primed && arrival - this->lastArrival > MIDI_CLOCK_TIMEOUT) {
+    unlock();
+  }
+
+  if (!this->primed) {
+    this->clockTime = arrival;
+    this->primed = true;
+  }
+  else if (!this->locked) {
+    this->period = (arrival - this->lastArrival) * 256;
+    this->clockTime = arrival;
+    this->locked = true;
+  }
+  else {
+    // each clock pulls our estimate part of the way towards when it arrived
+    const int64_t expected = this->clockTime + (this->period / 256);
+    const int64_t error = arrival - expected;
+    if (std::abs(error * 256) > (this->period >> MIDI_CLOCK_JUMP_SHIFT)) {
+      this->period = (arrival - this->lastArrival) * 256;
+      this->clockTime = arrival;
+    }
+    else {
+      this->clockTime = expected + (error / (1 << MIDI_CLOCK_PHASE_SHIFT));
+      this->period += (error * 256) / (1 << MIDI_CLOCK_PERIOD_SHIFT);
+    }
+  }
+  this->lastArrival = arrival;
+  if (this->running) {
+    this->clockCount++;
+  }
+  return;
+}
+
+void clockSync::start(void) {
+  this->running = true;
+  this->clockCount = 0;
+  return;
+}
+
+void clockSync::resume(void) {
+  this->running = true;
+  return;
+}
+
+void clockSync::stop(void) {
+  this->running = false;
+  return;
+}
+
+void clockSync::align(const uint64_t tick, const uint16_t division) {
+  this->clockCount = ((tick * MIDI_CLOCK_PPQN) + division - 1) / division;
+  return;
+}
+
+void clockSync::unlock(void) {
+  // our last period is kept as our best guess until a new one is measured
+  this->primed = false;
+  this->locked = false;
+  return;
+}
+
+bool clockSync::present(const int64_t now) const {
+  return this->primed && (now - this->lastArrival <= MIDI_CLOCK_TIMEOUT);
+}
+
+bool clockSync::isRunning(void) const {
+  return this->running;
+}
+
+bool clockSync::reaches(const uint64_t tick, const uint16_t division) const {
+  return tick * MIDI_CLOCK_PPQN < (uint64_t)this->clockCount * division;
+}
+
+int64_t clockSync::dueTime(const uint64_t tick, const uint16_t division) const {
+  // the number of clocks between our last clock and our tick, multiplied by our division
+  const int64_t offset = (int64_t)(tick * MIDI_CLOCK_PPQN) - ((int64_t)this->clockCount - 1) * division;
+  return this->clockTime + (offset * this->period) / ((int64_t)division * 256);
+}
+
+uint32_t clockSync::getTempo(void) const {
+  return this->locked ? (this->period * MIDI_CLOCK_PPQN) / 256 : 0;
+}
@@ -0,0 +1,23 @@
+#include "midi-noteTable.hpp"
+
+// filled in at compile time from every midi note number
+constexpr std::array<uint32_t, MIDI_NOTE_COUNT> noteTable = midi::buildNoteTable(midi::makeNoteSequence<MIDI_NOTE_COUNT>::type());
+
+// filled in at compile time from every midi note number, without folding
+constexpr std::array<uint32_t, MIDI_NOTE_COUNT> exactTable = midi::buildExactTable(midi::makeNoteSequence<MIDI_NOTE_COUNT>::type());
+
+// filled in at compile time from every cent of a semitone, including the whole semitone
+constexpr std::array<uint32_t, 101> centRatios = midi::buildCentTable(midi::makeNoteSequence<101>::type());
+static_assert(centRatios[100] == 69433, "our last cent must be a whole semitone");
+
+const std::array<uint32_t, MIDI_NOTE_COUNT>& midi::freqTable(void) {
+  return noteTable;
+}
+
+const std::array<uint32_t, MIDI_NOTE_COUNT>& midi::exactFreqTable(void) {
+  return exactTable;
+}
+
+const std::array<uint32_t, 101>& midi::centTable(void) {
+  return centRatios;
+}
@@ -0,0 +1,94 @@
+#include "midi-tempoMap.hpp"
+#include "midi.hpp"
+#include <algorithm>
+
+tempoMap::tempoMap(void) {
+  reset(0);
+}
+
+void tempoMap::reset(const uint16_t headerDiv) {
+  this->headerDiv = headerDiv;
+  this->segments.assign(1, tempoSegment());
+
+  // with timecode based timing, the upper byte of our division is the negative
+  // frame rate as a two's complement byte, and the lower byte is ticks per frame
+  // so every tick lasts 1000000 / (frames per second * ticks per frame) uS
+  this->smpteNum = this->smpteDen = 0;
+  if (headerDiv >> 15) {
+    const uint8_t ticksPerFrame = headerDiv & 0x00FF;
+    switch (headerDiv >> 8) {
+    case (SMPTE_24):
+      this->smpteNum = 1000000;
+      this->smpteDen = 24 * ticksPerFrame;
+      break;
+    case (SMPTE_25):
+      this->smpteNum = 1000000;
+      this->smpteDen = 25 * ticksPerFrame;
+      break;
+    case (SMPTE_29):
+      // 29 denotes 30 drop frame, which runs at 30000 / 1001 frames per second
+      this->smpteNum = 1001000;
+      this->smpteDen = 30 * ticksPerFrame;
+      break;
+    case (SMPTE_30):
+      this->smpteNum = 1000000;
+      this->smpteDen = 30 * ticksPerFrame;
+      break;
+    }
+  }
+  return;
+}
+
+void tempoMap::addTempo(const uint64_t tick, const uint32_t tempo) {
+  tempoSegment& last = this->segments.back();
+  if (tick <= last.tick) {
+    last.tempo = tempo;
+    return;
+  }
+
+  // the start of our new segment is found from the start
+  // of the previous segment and the tempo it was played at
+  tempoSegment next;
+  next.tick = tick;
+  next.scaledMicros = last.scaledMicros + (tick - last.tick) * last.tempo;
+  next.tempo = tempo;
+  this->segments.push_back(next);
+  return;
+}
+
+void tempoMap::discardHistory(void) {
+  this->segments.erase(this->segments.begin(), this->segments.end() - 1);
+  return;
+}
+
+const tempoMap::tempoSegment& tempoMap::findSegment(const uint64_t tick) const {
+  // most of our lookups happen in order, so check our last segment first
+  if (tick >= this->segments.back().tick) {
+    return this->segments.back();
+  }
+  auto next = std::upper_bound(this->segments.begin(), this->segments.end(), tick, [](const uint64_t tick, const tempoSegment& segment) {
+    return tick < segment.tick;
+  });
+  return *(next - 1);
+}
+
+uint64_t tempoMap::toMicros(const uint64_t tick) const {
+  // metrical timing, where our division is the number of ticks per quarter note
+  if (!(this->headerDiv >> 15)) {
+    if (this->headerDiv == 0) {
+      return 0;
+    }
+    const tempoSegment& segment = findSegment(tick);
+    return (segment.scaledMicros + (tick - segment.tick) * segment.tempo) / this->headerDiv;
+  }
+
+  // or timecode based timing, which tempo has no effect on
+  // an unrecognized frame rate or zero ticks per frame leaves us with no way
+  // of timing our events, so they are all played at once
+  else {
+    if (this->smpteDen == 0) {
+      return 0;
+    }
+    return (tick * this->smpteNum) / this->smpteDen;
+  }
+}
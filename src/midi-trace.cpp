@@ -0,0 +1,77 @@
+#include "midi-trace.hpp"
+#if SERIAL_DEBUG
+#include "ringBuffer.hpp"
+#include "sdio.hpp"
+#include <atomic>
+
+// records waiting to be drained. filled by our playback task and drained by our loop
+ringBuffer<traceRecord, TRACE_RECORDS> traceRing;
+
+// the number of records dropped since our last drain because our ring was full
+std::atomic<uint32_t> tracesDropped { 0 };
+
+void beginTrace(void) {
+  traceRing.clear();
+  tracesDropped = 0;
+  if (TRACE_TO_FILE) {
+    sdGuard guard;
+    FsFile traceFile;
+    traceFile.open(TRACE_FILE, O_RDWR | O_CREAT | O_TRUNC);
+    traceFile.close();
+  }
+  return;
+}
+
+void traceEvent(const uint32_t timestamp, const uint8_t event, const uint8_t note, const uint8_t stepperIdx, const uint32_t lateness) {
+  traceRecord record;
+  record.timestamp = timestamp;
+  record.lateness = lateness;
+  record.event = event;
+  record.note = note;
+  record.stepperIdx = stepperIdx;
+  if (!traceRing.push(record)) {
+    tracesDropped++;
+  }
+  return;
+}
+
+void drainTrace(void) {
+  std::array<traceRecord, TRACE_DRAIN_MAX> records;
+  size_t recordNum = 0;
+  while (recordNum < TRACE_DRAIN_MAX && traceRing.pop(records[recordNum])) {
+    recordNum++;
+  }
+
+  const uint32_t dropped = tracesDropped.exchange(0);
+  if (dropped > 0) {
+    Serial.print("Trace records dropped: ");
+    Serial.println(dropped);
+  }
+  if (recordNum == 0) {
+    return;
+  }
+
+  // our records are written exactly as they are held in memory
+  if (TRACE_TO_FILE) {
+    sdGuard guard;
+    FsFile traceFile;
+    if (traceFile.open(TRACE_FILE, SD_FILE_WRITE)) {
+      traceFile.write(records.data(), recordNum * sizeof(traceRecord));
+      traceFile.close();
+    }
+    return;
+  }
+  for (size_t i = 0; i < recordNum; i++) {
+    Serial.print(records[i].timestamp);
+    Serial.print(" - Lateness in uS: ");
+    Serial.print(records[i].lateness);
+    Serial.print(" | Event: ");
+    Serial.print(records[i].event);
+    Serial.print(" | Note: ");
+    Serial.print(records[i].note);
+    Serial.print(" | Stepper Index: ");
+    Serial.println(records[i].stepperIdx);
+  }
+  return;
+}
+#endif
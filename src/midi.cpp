@@ -1,39 +1,147 @@
 #include "midi.hpp"
+#include "midi-trace.hpp"
+#include "stepper-modulation.hpp"
 #include "stepper.hpp"
+#include "uart-latency.hpp"
+#include "uart-thru.hpp"
+#include "uart.hpp"
+#include <esp_timer.h>
 #include <algorithm>
-#include <cmath>
-#include <sstream>
+#include <functional>
 #include <vector>
 
 midiFile songData;
 
-void midiFile::assignQueue(std::queue<uint8_t>* fileContents) {
-  this->byteArray = fileContents;
+midiFile::~midiFile(void) {
+  releaseEvents();
+}
+
+void midiFile::assignSource(midiByteSource* fileContents) {
+  this->byteSource = fileContents;
   return;
 }
 
 bool midiFile::parseMidi(void) {
   std::deque<midiEvent> trackData;
+  std::vector<std::deque<midiEvent>> tracks;
 
-  if (this->byteArray->empty() || !populateHeaderChunk()) {
-    delete this->byteArray;
+  beginStats();
+  this->parseError = false;
+  if (this->byteSource->available() == 0 || !populateHeaderChunk()) {
+    this->byteSource = NULL;
     return false;
   }
 
-  for (uint8_t i = 0; i < this->headerChunk.headerTrackNum; i++) {
-    if (!populateTrackChunks(i, trackData)) {
+  // each track is parsed into its own deque so that
+  // they can later be merged in time order
+  tracks.resize(this->headerChunk.headerTrackNum);
+  for (uint16_t i = 0; i < this->headerChunk.headerTrackNum; i++) {
+    if (!populateTrackChunks(i, tracks[i])) {
+      this->byteSource = NULL;
       return false;
     }
   }
 
-  analyzeOverlaps(trackData);
-  sortEvents(trackData);
+  mergeTracks(tracks, trackData);
   convertDeltaTime(trackData);
+  analyzeOverlaps(trackData);
   enqueueEvents(trackData);
-  delete this->byteArray;
-  this->byteArray = NULL;
-  if (this->eventQueue->front().deltaTime != 0) {
-    this->eventQueue->front().deltaTime = 0;
+  endStats();
+  this->byteSource = NULL;
+  return true;
+}
+
+bool midiFile::parseMidiIncremental(FsFile* file) {
+  // our header chunk is made up of its type and length
+  // followed by HEADER_LEN bytes of data
+  uint64_t offset = 8 + HEADER_LEN;
+  fileByteSource header(file, 0, offset, offset);
+  beginStats();
+  this->parseError = false;
+  this->byteSource = &header;
+  if (!populateHeaderChunk()) {
+    this->byteSource = NULL;
+    return false;
+  }
+
+  // we only read the type and length of each track chunk here
+  // so that each track's cursor knows where its track starts and ends
+  this->trackCursors = new std::vector<trackCursor>;
+  this->trackCursors->reserve(this->headerChunk.headerTrackNum);
+  for (uint16_t i = 0; i < this->headerChunk.headerTrackNum; i++) {
+    fileByteSource chunkHeader(file, offset, 8, 8);
+    this->byteSource = &chunkHeader;
+    if (readChunkData32() != CHUNKTYPE_TRACK) {
+      releaseEvents();
+      return false;
+    }
+
+    // a track can't be longer than what remains of our file
+    uint32_t trackChunkLen = readChunkData32();
+    if (this->parseError || offset + 8 + trackChunkLen > file->fileSize()) {
+      releaseEvents();
+      return false;
+    }
+    this->trackCursors->emplace_back(file, offset + 8, trackChunkLen, i);
+    offset += 8 + trackChunkLen;
+  }
+  this->byteSource = NULL;
+
+  // our merge front starts out holding the first event of each track
+  this->mergeFront.clear();
+  for (trackCursor& cursor : *this->trackCursors) {
+    if (advanceCursor(cursor)) {
+      this->mergeFront.push_back(makeHead(cursor.next));
+    }
+  }
+  std::make_heap(this->mergeFront.begin(), this->mergeFront.end(), std::greater<trackHead>());
+
+  this->holdingEvent = false;
+  this->pendingDeltaTime = 0;
+  this->lastTick = 0;
+  this->tempos.reset(this->headerChunk.headerDiv);
+  beginAnalysis();
+  endStats();
+  return true;
+}
+
+midiFile::trackCursor::trackCursor(FsFile* file, const uint64_t start, const uint32_t length, const uint8_t trackNum) : source(file, start, length, MIDI_TRACK_BLOCK_SIZE), remaining(length), trackNum(trackNum) {
+}
+
+bool midiFile::advanceCursor(trackCursor& cursor) {
+  this->byteSource = &cursor.source;
+  while (cursor.remaining > 0) {
+    midiEvent event;
+    event.track = cursor.trackNum;
+    cursor.remaining -= std::min(readTrackEvent(cursor.prevEvent, cursor.absoluteDT, event, cursor.remaining), cursor.remaining);
+
+    // as we may already be playing, a corrupt track is simply ended early
+    if (this->parseError) {
+      this->parseError = false;
+      cursor.remaining = 0;
+      return false;
+    }
+    if (isPlaybackEvent(event)) {
+      cursor.next = event;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool midiFile::mergeNext(midiEvent& event) {
+  if (this->mergeFront.empty()) {
+    return false;
+  }
+  std::pop_heap(this->mergeFront.begin(), this->mergeFront.end(), std::greater<trackHead>());
+  trackCursor& cursor = (*this->trackCursors)[this->mergeFront.back().track];
+  this->mergeFront.pop_back();
+  event = cursor.next;
+
+  // replace the event we just took with the next event from the same track
+  if (advanceCursor(cursor)) {
+    this->mergeFront.push_back(makeHead(cursor.next));
+    std::push_heap(this->mergeFront.begin(), this->mergeFront.end(), std::greater<trackHead>());
   }
   return true;
 }
@@ -51,12 +159,19 @@ bool midiFile::populateHeaderChunk(void) {
 
   // find the number of tracks in the midi file
   this->headerChunk.headerTrackNum = readChunkData16();
-  trackPolyphony.resize(headerChunk.headerTrackNum, false);
+  if (this->headerChunk.headerTrackNum > MIDI_TRACK_MAX) {
+    return false;
+  }
+  trackProfiles.assign(headerChunk.headerTrackNum, trackProfile());
 
   // finally, read in the division information
   // to know what to expect of our midi's delta times
+  // a division of 0 gives our ticks no length, so our midi file is likely invalid
   this->headerChunk.headerDiv = readChunkData16();
-  return true;
+  if (this->headerChunk.headerDiv == 0) {
+    return false;
+  }
+  return !this->parseError;
 }
 
 bool midiFile::populateTrackChunks(const uint8_t trackNum, std::deque<midiEvent>& trackData) {
@@ -76,56 +191,99 @@ bool midiFile::populateTrackChunks(const uint8_t trackNum, std::deque<midiEvent>
   // if there is one
   trackChunkLen = readChunkData32();
 
+  // a track can't be longer than what remains of our file
+  if (this->parseError || trackChunkLen > this->byteSource->available()) {
+    return false;
+  }
+
   // here we will iterate over our bytes
   // which make up our midi events and delta times
   // we know the expected length of the chunk
   // in bytes. we use i to keep track
   // of the number of bytes we've already read in
-  // to ensure we read only what's necessary
+  // to ensure we read only what's necessary. every event consumes
+  // at least one byte and we stop at our first error
+  // so a track can never take longer to parse than its length
   for (uint32_t i = 0; i < trackChunkLen;) {
     midiFile::midiEvent tempEvent;
     tempEvent.track = trackNum;
-    i += readVariableLen(tempEvent.deltaTime);
-
-    // to allow use to merge all tracks into a single
-    // queue of events later, we must convert
-    // our deltaTimes from values relative to the
-    // previous event to absolute times from the
-    // start of the track
-    tempEvent.deltaTime += absoluteDT;
-    absoluteDT = tempEvent.deltaTime;
-
-    i += readMidiEvent(prevEvent, tempEvent.eventType);
-    i += readMidiEventData(tempEvent.eventType, tempEvent.metaType, tempEvent.eventData);
-
-    // to simplify playback, we check the velocity
-    // of our note on events. if velocity is 0,
-    // volume is 0 and our event is functionally
-    // a note off event
-    if (((tempEvent.eventType & 0xF0) == MIDI_NOTE_ON) && ((tempEvent.eventData & 0x00FF) == 0)) {
-      tempEvent.eventType = (tempEvent.eventType & 0x8F);
-    }
-
-    // because our stepper motor does not have
-    // volume control, velocity has no value for us
-    // shift our event data 8 bits over
-    // so that only our note data is stored
-    if (((tempEvent.eventType & 0xF0) == MIDI_NOTE_ON) || ((tempEvent.eventType & 0xF0) == MIDI_NOTE_OFF)) {
-      tempEvent.eventData = tempEvent.eventData >> 8;
+    i += readTrackEvent(prevEvent, absoluteDT, tempEvent, trackChunkLen - i);
+    if (this->parseError || i > trackChunkLen) {
+      return false;
     }
 
-    // we only want to store note on, note off, and tempo events
+    // we only want to store note on, note off, pitch bend, tempo events
+    // and the controllers our steppers respond to
     // no other events have any use to us for playback
     // via our stepper motors
-    if (((tempEvent.eventType & 0xF0) == MIDI_NOTE_OFF) || ((tempEvent.eventType & 0xF0) == MIDI_NOTE_ON) || (tempEvent.metaType == MIDI_META_TEMPO)) {
+    if (isPlaybackEvent(tempEvent)) {
       trackData.push_back(tempEvent);
     }
   }
   return true;
 }
 
+uint32_t midiFile::readTrackEvent(uint8_t& prevEvent, uint64_t& absoluteDT, midiEvent& event, const uint32_t limit) {
+  uint32_t bytesRead = readVariableLen(event.deltaTime);
+  this->stats.eventsRead++;
+
+  // to allow use to merge all tracks into a single
+  // queue of events later, we must convert
+  // our deltaTimes from values relative to the
+  // previous event to absolute times from the
+  // start of the track
+  event.deltaTime += absoluteDT;
+  absoluteDT = event.deltaTime;
+
+  bytesRead += readMidiEvent(prevEvent, event.eventType);
+  bytesRead += readMidiEventData(event.eventType, event.metaType, event.eventData, (bytesRead < limit) ? (limit - bytesRead) : 0);
+
+  // to simplify playback, we check the velocity
+  // of our note on events. if velocity is 0,
+  // volume is 0 and our event is functionally
+  // a note off event
+  if (((event.eventType & 0xF0) == MIDI_NOTE_ON) && ((event.eventData & 0x00FF) == 0)) {
+    event.eventType = (event.eventType & 0x8F);
+  }
+
+  // because our stepper motor does not have
+  // volume control, velocity has no value for us
+  // shift our event data 8 bits over
+  // so that only our note data is stored
+  if (((event.eventType & 0xF0) == MIDI_NOTE_ON) || ((event.eventType & 0xF0) == MIDI_NOTE_OFF)) {
+    event.velocity = event.eventData & 0x00FF;
+    event.eventData = event.eventData >> 8;
+  }
+  return bytesRead;
+}
+
+bool midiFile::isPlaybackEvent(const midiEvent& event) {
+  switch (event.eventType & 0xF0) {
+  case (MIDI_NOTE_OFF):
+  case (MIDI_NOTE_ON):
+  case (MIDI_PITCH_BEND):
+    return true;
+
+  // the controller number is the upper byte of our event data
+  case (MIDI_CONTROL_CHANGE):
+    switch ((event.eventData >> 8) & 0x7F) {
+    case (MIDI_CC_MODULATION):
+    case (MIDI_CC_PORTAMENTO_TIME):
+    case (MIDI_CC_DATA_ENTRY):
+    case (MIDI_CC_DATA_ENTRY_LSB):
+    case (MIDI_CC_PORTAMENTO):
+    case (MIDI_CC_RPN_LSB):
+    case (MIDI_CC_RPN_MSB):
+    case (MIDI_CC_RESET_CONTROLLERS):
+      return true;
+    }
+    return false;
+  }
+  return (event.metaType == MIDI_META_TEMPO);
+}
+
 uint8_t midiFile::readMidiEvent(uint8_t& prevEvent, uint8_t& eventType) {
-  if (this->byteArray->front() >= 0x80) {
+  if (this->byteSource->peek() >= 0x80) {
     eventType = prevEvent = readByte();
     return 1;
   }
@@ -135,9 +293,9 @@ uint8_t midiFile::readMidiEvent(uint8_t& prevEvent, uint8_t& eventType) {
   }
 }
 
-uint8_t midiFile::readMidiEventData(const uint8_t eventType, uint8_t& metaType, uint32_t& eventData) {
+uint32_t midiFile::readMidiEventData(const uint8_t eventType, uint8_t& metaType, uint32_t& eventData, const uint32_t limit) {
   uint32_t eventLen = 0;
-  uint8_t bytesRead = 0;
+  uint32_t bytesRead = 0;
   switch (eventType & 0xF0) {
   case (0x80):
   case (0x90):
@@ -157,6 +315,18 @@ uint8_t midiFile::readMidiEventData(const uint8_t eventType, uint8_t& metaType,
     }
     bytesRead += readVariableLen(eventLen);
     break;
+
+  // a data byte with no previous status for running status to fall back on
+  default:
+    this->parseError = true;
+    return bytesRead;
+  }
+
+  // the length of meta and sysex events comes from our file
+  // so it must be checked against what is actually left of our track
+  if (bytesRead > limit || eventLen > limit - bytesRead) {
+    this->parseError = true;
+    return bytesRead;
   }
   for (uint32_t i = 0; i < eventLen; i++, bytesRead++) {
     eventData = (eventData << 8) | readByte();
@@ -166,12 +336,18 @@ uint8_t midiFile::readMidiEventData(const uint8_t eventType, uint8_t& metaType,
 
 uint8_t midiFile::readVariableLen(uint32_t& varLenQuantity) {
   uint8_t bytesRead = 0;
-  while (this->byteArray->front() >= 0x80) {
-    varLenQuantity = (varLenQuantity << 7) | (readByte() & 0x7F);
+  uint8_t byte = 0;
+
+  // variable length quantities are at most 4 bytes long
+  // a continuation bit on the fourth byte means our file is corrupt
+  do {
+    byte = readByte();
+    varLenQuantity = (varLenQuantity << 7) | (byte & 0x7F);
     bytesRead++;
+  } while ((byte & 0x80) && bytesRead < 4);
+  if (byte & 0x80) {
+    this->parseError = true;
   }
-  varLenQuantity = (varLenQuantity << 7) | (readByte() & 0x7F);
-  bytesRead++;
   return bytesRead;
 }
 
@@ -198,115 +374,842 @@ uint16_t midiFile::readChunkData16(void) {
 }
 
 uint8_t midiFile::readByte() {
-  if (!this->byteArray->empty()) {
-    uint8_t byte = this->byteArray->front();
-    this->byteArray->pop();
-    return byte;
-  }
-  else {
+  // reading past the end of our file means our file lied to us
+  // about the length of something, so there is no point in continuing
+  if (this->byteSource->available() == 0) {
+    this->parseError = true;
     return 0;
   }
+  this->stats.bytesRead++;
+  return this->byteSource->read();
 }
 
-void midiFile::sortEvents(std::deque<midiEvent>& trackData) {
-  std::sort(trackData.begin(), trackData.end(), [](const midiEvent& a, const midiEvent& b) {
-    return ((a.deltaTime != b.deltaTime) ? (a.deltaTime < b.deltaTime) : ((a.eventType == b.eventType) || (a.eventType == MIDI_META_EVENT)));
-  });
-  return;
+bool midiFile::trackHead::operator>(const trackHead& other) const {
+  if (this->deltaTime != other.deltaTime) {
+    return this->deltaTime > other.deltaTime;
+  }
+  if (this->priority != other.priority) {
+    return this->priority > other.priority;
+  }
+  return this->track > other.track;
 }
 
-void midiFile::convertDeltaTime(std::deque<midiEvent>& trackData) {
-  uint32_t workingTempo = 500000;
+midiFile::trackHead midiFile::makeHead(const midiEvent& event) {
+  return trackHead { event.deltaTime, (uint8_t)((event.metaType == MIDI_META_TEMPO) ? 0 : 1), event.track };
+}
 
-  // it's important that we first convert our deltaTimes from absolute value
-  // since the start of the track back to relative values since the last event
-  for (uint32_t i = trackData.size(); i > 0; i--) {
-    if (trackData[i].deltaTime != 0) {
-      trackData[i].deltaTime = trackData[i].deltaTime - trackData[i - 1].deltaTime;
+void midiFile::mergeTracks(std::vector<std::deque<midiEvent>>& tracks, std::deque<midiEvent>& trackData) {
+  std::vector<trackHead> heapStorage;
+  heapStorage.reserve(tracks.size());
+  std::priority_queue<trackHead, std::vector<trackHead>, std::greater<trackHead>> heads(std::greater<trackHead>(), std::move(heapStorage));
+  for (uint8_t i = 0; i < tracks.size(); i++) {
+    if (!tracks[i].empty()) {
+      heads.push(makeHead(tracks[i].front()));
     }
   }
 
-  // now we check the format of our header chunk's tickdivs value
-  // this tells us if we're using metrical timing
-  if (!(this->headerChunk.headerDiv >> 15)) {
-    for (uint32_t i = 0; i < trackData.size(); i++) {
-      if ((trackData[i].eventType == MIDI_META_EVENT) && (trackData[i].metaType == MIDI_META_TEMPO)) {
-        workingTempo = trackData[i].eventData;
-      }
-      trackData[i].deltaTime = (workingTempo * trackData[i].deltaTime) / this->headerChunk.headerDiv;
+  // repeatedly take the earliest event of all our tracks
+  // then replace it on our heap with the next event of the same track
+  while (!heads.empty()) {
+    const uint8_t track = heads.top().track;
+    heads.pop();
+    trackData.push_back(tracks[track].front());
+    tracks[track].pop_front();
+    if (!tracks[track].empty()) {
+      heads.push(makeHead(tracks[track].front()));
     }
   }
+  return;
+}
 
-  // or if we're using timecodes
-  else {
-    for (uint32_t i = 0; i < trackData.size(); i++) {
-      trackData[i].deltaTime = pow((~((this->headerChunk.headerDiv >> 8) - 1) * (this->headerChunk.headerDiv & 0x00FF) * 1000), -1) * trackData[i].deltaTime;
-    }
+void midiFile::convertDeltaTime(std::deque<midiEvent>& trackData) {
+  uint64_t lastTick = 0;
+  for (midiEvent& event : trackData) {
+    const uint64_t tick = event.deltaTime;
+    event.deltaTime = tick - lastTick;
+    lastTick = tick;
   }
   return;
 }
 
+playbackEvent midiFile::packEvent(const midiEvent& event, const uint32_t deltaTime) {
+  playbackEvent packed;
+  packed.deltaTime = deltaTime;
+  packed.channel = event.eventType & 0x0F;
+  packed.track = event.track;
+  if (event.eventType == MIDI_META_EVENT) {
+    packed.eventKind = PLAYBACK_TEMPO;
+    packed.note = (event.eventData >> 16) & 0xFF;
+    packed.velocity = (event.eventData >> 8) & 0xFF;
+    packed.channel = event.eventData & 0xFF;
+    return packed;
+  }
+  switch (event.eventType & 0xF0) {
+  case (MIDI_NOTE_ON):
+  case (MIDI_NOTE_OFF):
+    packed.eventKind = ((event.eventType & 0xF0) == MIDI_NOTE_ON) ? PLAYBACK_NOTE_ON : PLAYBACK_NOTE_OFF;
+    packed.note = event.eventData & 0x7F;
+    packed.velocity = event.velocity;
+    break;
+
+  // both data bytes of these events are left as they were in our file
+  // with the first in the upper byte of our event data
+  default:
+    packed.eventKind = ((event.eventType & 0xF0) == MIDI_PITCH_BEND) ? PLAYBACK_PITCH_BEND : PLAYBACK_CONTROL;
+    packed.note = (event.eventData >> 8) & 0x7F;
+    packed.velocity = event.eventData & 0x7F;
+    break;
+  }
+  return packed;
+}
+
+playbackEvent midiFile::packRest(void) {
+  playbackEvent packed;
+  packed.deltaTime = PLAYBACK_DELTA_MAX;
+  packed.eventKind = PLAYBACK_REST;
+  packed.note = packed.channel = packed.track = packed.velocity = 0;
+  return packed;
+}
+
 void midiFile::enqueueEvents(std::deque<midiEvent>& trackData) {
-  this->eventQueue = new std::queue<midiEvent>;
+  uint64_t pendingDeltaTime = 0;
+  this->eventQueue = new std::vector<playbackEvent>;
   while (!trackData.empty()) {
-    if ((trackData.front().getEventOrChannel(true) == MIDI_NOTE_ON) || (trackData.front().getEventOrChannel(true) == MIDI_NOTE_OFF)) {
-      trackData.front().eventData = midi::getFreq((uint8_t)trackData.front().eventData);
-      this->eventQueue->push(trackData.front());
+    // delta times too long to fit in our event are split
+    // off into rests placed ahead of our event
+    pendingDeltaTime += trackData.front().deltaTime;
+    while (pendingDeltaTime > PLAYBACK_DELTA_MAX) {
+      this->eventQueue->push_back(packRest());
+      pendingDeltaTime -= PLAYBACK_DELTA_MAX;
     }
+    this->eventQueue->push_back(packEvent(trackData.front(), pendingDeltaTime));
+    pendingDeltaTime = 0;
     trackData.pop_front();
   }
+  this->eventQueue->shrink_to_fit();
   return;
 }
 
-void midiFile::playMidi(void) {
-  std::stringstream debugString;
-  uint16_t eventNum = 1;
-  midiFile::midiEvent currentEvent;
-  while (!this->eventQueue->empty()) {
-    currentEvent = this->eventQueue->front();
-    debugString << "\n"
-                << eventNum;
-    playNote(currentEvent.deltaTime, currentEvent.eventData, currentEvent.eventType, trackPolyphony[currentEvent.track], debugString);
-    this->eventQueue->pop();
-    eventNum++;
+bool midiFile::produceEvent(playbackEvent& event) {
+  if (this->eventQueue != NULL) {
+    if (this->queueIdx >= this->eventQueue->size()) {
+      return false;
+    }
+    event = (*this->eventQueue)[this->queueIdx++];
+    return true;
+  }
+  if (this->trackCursors == NULL) {
+    return false;
+  }
+
+  // merge our next event, converting its absolute time to a delta time
+  // tempo events are passed on to our playback task, but our analysis
+  // also needs their tempo to measure how long our notes overlap in uS
+  if (!this->holdingEvent) {
+    if (!mergeNext(this->heldEvent)) {
+      return false;
+    }
+    this->pendingDeltaTime += this->heldEvent.deltaTime - this->lastTick;
+    this->lastTick = this->heldEvent.deltaTime;
+
+    // as our merged events only ever move forward in time
+    // only the most recent tempo needs to be kept
+    if (this->heldEvent.eventType == MIDI_META_EVENT) {
+      this->tempos.addTempo(this->heldEvent.deltaTime, this->heldEvent.eventData);
+      this->tempos.discardHistory();
+    }
+    else {
+      analyzeEvent(this->heldEvent, this->tempos.toMicros(this->heldEvent.deltaTime));
+    }
+    this->holdingEvent = true;
+  }
+
+  // delta times too long to fit in our event are split
+  // off into rests, and our event is held on to until what remains fits
+  if (this->pendingDeltaTime > PLAYBACK_DELTA_MAX) {
+    event = packRest();
+    this->pendingDeltaTime -= PLAYBACK_DELTA_MAX;
+    return true;
+  }
+  event = packEvent(this->heldEvent, this->pendingDeltaTime);
+  this->pendingDeltaTime = 0;
+  this->holdingEvent = false;
+  return true;
+}
+
+void midiFile::fillLookahead(void) {
+  playbackEvent event;
+  while (this->eventsRemaining && !this->lookahead.full()) {
+    // once our song runs out of events our window will drain to nothing
+    // so our watermarks are recorded before that happens
+    if (!produceEvent(event)) {
+      recordWatermarks();
+      this->eventsRemaining = false;
+      return;
+    }
+    this->lookahead.push(event);
   }
-  Serial.println(debugString.str().c_str());
+  return;
+}
+
+void midiFile::recordWatermarks(void) {
+  this->playStats.lookaheadLow = this->lookahead.lowWatermark();
+  this->playStats.lookaheadHigh = this->lookahead.highWatermark();
+  return;
+}
+
+void midiFile::releaseEvents(void) {
   delete this->eventQueue;
   this->eventQueue = NULL;
+  delete this->trackCursors;
+  this->trackCursors = NULL;
+  this->mergeFront.clear();
+  this->lookahead.clear();
+  this->voiceStates.clear();
+  this->byteSource = NULL;
   return;
 }
 
-void midiFile::analyzeOverlaps(const std::deque<midiFile::midiEvent>& trackData) {
-  const uint32_t scientificallyChosenOverlapThreshold = 250000;
-  for (size_t i = 0; i < trackData.size(); i++) {
-    if ((trackData[i].eventType & 0xF0) == MIDI_NOTE_ON && trackPolyphony[trackData[i].track]) {
-      const midiFile::midiEvent* noteOn = &trackData[i];
-      const midiFile::midiEvent* noteOff;
-      std::vector<const midiFile::midiEvent*> intersectingNoteOns;
-      // Grab all the unrelated note_on events until the corresponding note_off
-      for (size_t j = i + 1; j < trackData.size(); j++) {
-        if (((trackData[j].eventType ^ noteOn->eventType) == 0x10) && !(trackData[j].eventData ^ noteOn->eventData)) {
-          noteOff = &trackData[j];
+bool midiFile::saveEvents(FsFile& file) {
+  const uint16_t trackNum = this->trackProfiles.size();
+  const uint32_t eventCount = this->eventQueue->size();
+  if (file.write(&this->headerChunk, sizeof(this->headerChunk)) != sizeof(this->headerChunk) || file.write(&trackNum, sizeof(trackNum)) != sizeof(trackNum)) {
+    return false;
+  }
+  return (file.write(this->trackProfiles.data(), trackNum * sizeof(trackProfile)) == trackNum * sizeof(trackProfile))
+         && (file.write(&eventCount, sizeof(eventCount)) == sizeof(eventCount))
+         && (file.write(this->eventQueue->data(), eventCount * sizeof(playbackEvent)) == eventCount * sizeof(playbackEvent));
+}
+
+bool midiFile::loadEvents(FsFile& file, FsFile& song) {
+  uint16_t trackNum = 0;
+  uint32_t eventCount = 0;
+
+  // our song's own header is read first, so that a cache that
+  // no longer describes it is never trusted
+  fileByteSource songHeader(&song, 0, 8 + HEADER_LEN, 8 + HEADER_LEN);
+  assignSource(&songHeader);
+  this->parseError = false;
+  const bool songValid = populateHeaderChunk();
+  const auto expected = this->headerChunk;
+  this->byteSource = NULL;
+  if (!songValid || file.read(&this->headerChunk, sizeof(this->headerChunk)) != sizeof(this->headerChunk) || file.read(&trackNum, sizeof(trackNum)) != sizeof(trackNum)) {
+    return false;
+  }
+  if (this->headerChunk.headerFormat != expected.headerFormat || this->headerChunk.headerTrackNum != expected.headerTrackNum
+      || this->headerChunk.headerDiv != expected.headerDiv || trackNum != expected.headerTrackNum) {
+    return false;
+  }
+  this->trackProfiles.assign(trackNum, trackProfile());
+  if (file.read(this->trackProfiles.data(), trackNum * sizeof(trackProfile)) != (int)(trackNum * sizeof(trackProfile))) {
+    return false;
+  }
+
+  // make sure our file actually holds as many events as it claims to
+  // before allocating room for them
+  if (file.read(&eventCount, sizeof(eventCount)) != sizeof(eventCount) || (uint64_t)eventCount * sizeof(playbackEvent) != file.fileSize() - file.curPosition()) {
+    return false;
+  }
+  this->eventQueue = new std::vector<playbackEvent>(eventCount);
+  if (file.read(this->eventQueue->data(), eventCount * sizeof(playbackEvent)) != (int)(eventCount * sizeof(playbackEvent))) {
+    delete this->eventQueue;
+    this->eventQueue = NULL;
+    return false;
+  }
+  return true;
+}
+
+bool midiFile::startTask(void) {
+  if (this->playbackTask == NULL) {
+    BaseType_t success = xTaskCreatePinnedToCore(playbackLoop, "Playback", MIDI_PLAYBACK_STACK, this, MIDI_PLAYBACK_PRIORITY, &this->playbackTask, MIDI_PLAYBACK_CORE);
+    if (!success) {
+      if (SERIAL_DEBUG) {
+        Serial.println("Failed to create playback task. Aborting.");
+      }
+      this->playbackTask = NULL;
+      return false;
+    }
+  }
+  if (this->playbackTimer == NULL) {
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = &midiFile::playbackCallback;
+    timerArgs.arg = this;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "playback";
+    if (esp_timer_create(&timerArgs, &this->playbackTimer) != ESP_OK) {
+      this->playbackTimer = NULL;
+      return false;
+    }
+  }
+  if (this->controlTimer == NULL) {
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = &midiFile::controlCallback;
+    timerArgs.arg = this;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "control";
+    if (esp_timer_create(&timerArgs, &this->controlTimer) != ESP_OK) {
+      this->controlTimer = NULL;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool midiFile::playMidi(void) {
+  if (!startTask()) {
+    releaseEvents();
+    return false;
+  }
+
+  this->queueIdx = 0;
+  this->lookahead.clear();
+  this->eventsRemaining = true;
+  this->eventPending = false;
+  this->songTick = 0;
+  this->songTempos.reset(this->headerChunk.headerDiv);
+  this->songStarted = false;
+  this->rewindPending = false;
+  this->playStats = playbackStats();
+  fillLookahead();
+  this->lookahead.resetWatermarks();
+  beginTrace();
+
+  // our playback task resets our controllers before it starts our song
+  // and decides whether our song follows its own tempo or our master's clock
+  this->songLoaded = true;
+  this->playing = true;
+  if (!startControl()) {
+    this->playing = false;
+    finishPlayback();
+    return false;
+  }
+  request(MIDI_NOTIFY_RESET | MIDI_NOTIFY_START);
+  return true;
+}
+
+bool midiFile::updateMidi(void) {
+  if (!this->songLoaded) {
+    return false;
+  }
+  if (this->playing) {
+    if (this->rewindPending) {
+      rewind();
+    }
+    fillLookahead();
+    return true;
+  }
+  finishPlayback();
+  return false;
+}
+
+void midiFile::rewind(void) {
+  // our playback task leaves our window alone until our rewind is done
+  // so we are free to empty it from here
+  this->lookahead.clear();
+  this->queueIdx = 0;
+  this->eventsRemaining = true;
+  fillLookahead();
+  this->rewindPending = false;
+  xTaskNotify(this->playbackTask, MIDI_NOTIFY_EVENTS, eSetBits);
+  return;
+}
+
+void midiFile::stopMidi(void) {
+  if (!this->songLoaded) {
+    return;
+  }
+
+  // our task may be playing events as we stop our timer, and may rearm it
+  // before it notices we've stopped, so we wait it out and stop our timer again
+  this->playing = false;
+  esp_timer_stop(this->playbackTimer);
+  stopControl();
+  while (this->dispatching) {
+    delay(1);
+  }
+  esp_timer_stop(this->playbackTimer);
+  request(MIDI_NOTIFY_SILENCE);
+  finishPlayback();
+  return;
+}
+
+bool midiFile::startLive(void) {
+  if (!startTask() || !startControl()) {
+    return false;
+  }
+  this->liveInput = true;
+  return true;
+}
+
+void midiFile::notifyLive(void) {
+  if (this->liveInput) {
+    xTaskNotify(this->playbackTask, MIDI_NOTIFY_LIVE, eSetBits);
+  }
+  return;
+}
+
+void midiFile::request(const uint32_t requests) {
+  this->pendingRequests |= requests;
+  xTaskNotify(this->playbackTask, requests, eSetBits);
+  while (this->pendingRequests & requests) {
+    delay(1);
+  }
+  return;
+}
+
+void midiFile::playbackCallback(void* arg) {
+  xTaskNotify(static_cast<midiFile*>(arg)->playbackTask, MIDI_NOTIFY_EVENTS, eSetBits);
+  return;
+}
+
+void midiFile::controlCallback(void* arg) {
+  xTaskNotify(static_cast<midiFile*>(arg)->playbackTask, MIDI_NOTIFY_CONTROL, eSetBits);
+  return;
+}
+
+void midiFile::playbackLoop(void* pvParameters) {
+  midiFile* song = static_cast<midiFile*>(pvParameters);
+  uint32_t notifications = 0;
+  for (;;) {
+    xTaskNotifyWait(0, UINT32_MAX, &notifications, portMAX_DELAY);
+
+    // requests from other tasks are carried out first, so that a song
+    // starts from reset controllers and stops before anything else is played
+    if (notifications & MIDI_NOTIFY_RESET) {
+      resetControllers();
+    }
+    if (notifications & MIDI_NOTIFY_SILENCE) {
+      silenceSteppers();
+      silenceThru(song->thruChannels);
+      song->thruChannels = 0;
+    }
+    if (notifications & MIDI_NOTIFY_START) {
+      song->beginSong();
+    }
+    song->pendingRequests &= ~(notifications & (MIDI_NOTIFY_RESET | MIDI_NOTIFY_SILENCE | MIDI_NOTIFY_START));
+
+    if (notifications & MIDI_NOTIFY_EVENTS) {
+      song->dispatchEvents();
+    }
+    if (notifications & MIDI_NOTIFY_CONTROL) {
+      song->dispatchControl();
+    }
+    if (notifications & MIDI_NOTIFY_LIVE) {
+      song->dispatchLive();
+    }
+  }
+  vTaskDelete(nullptr);
+}
+
+bool midiFile::startControl(void) {
+  // live input may have left our timer running already
+  if (this->liveInput) {
+    return true;
+  }
+  return esp_timer_start_periodic(this->controlTimer, MODULATION_PERIOD) == ESP_OK;
+}
+
+void midiFile::stopControl(void) {
+  if (!this->liveInput) {
+    esp_timer_stop(this->controlTimer);
+  }
+  return;
+}
+
+void midiFile::beginSong(void) {
+  this->thruChannels = 0;
+  resetThruStats();
+
+  // a song timed by timecode has no beats for our master's clock to count
+  this->slaved = !(this->headerChunk.headerDiv >> 15) && this->externalClock.present(esp_timer_get_time());
+  if (!this->slaved) {
+    dispatchEvents();
+    return;
+  }
+
+  // if our master is already playing, our song joins in from its next clock
+  // otherwise it waits for our master to start it
+  this->externalClock.align(0, this->headerChunk.headerDiv);
+  if (SERIAL_DEBUG) {
+    Serial.println("External clock found. Waiting for it to play our song.");
+  }
+  return;
+}
+
+void midiFile::followClock(void) {
+  if (this->slaved || (this->headerChunk.headerDiv >> 15)) {
+    return;
+  }
+  esp_timer_stop(this->playbackTimer);
+  this->externalClock.align(this->songTick, this->headerChunk.headerDiv);
+  this->slaved = true;
+  return;
+}
+
+bool midiFile::applyTransport(const liveMessage& message) {
+  // our message's timestamp only holds the lower 32 bits of the time it arrived
+  const int64_t now = esp_timer_get_time();
+  const int64_t arrival = now - (uint32_t)((uint32_t)now - message.timestamp);
+  const bool loaded = this->playing && !(this->headerChunk.headerDiv >> 15);
+  switch (message.status) {
+  case (MIDI_CLOCK):
+    this->externalClock.clock(arrival);
+    return true;
+
+  // our song is sent back to its start, unless it is parsed incrementally
+  // in which case it can't go back and picks up from where it is instead
+  case (MIDI_START):
+    this->externalClock.start();
+    if (!loaded) {
+      return false;
+    }
+    if (this->songStarted && this->eventQueue != NULL) {
+      esp_timer_stop(this->playbackTimer);
+      silenceSteppers();
+      silenceThru(this->thruChannels);
+      this->songTick = 0;
+      this->songTempos.reset(this->headerChunk.headerDiv);
+      this->eventPending = false;
+      this->songStarted = false;
+      this->slaved = true;
+      this->rewindPending = true;
+      return false;
+    }
+    followClock();
+    if (this->songStarted) {
+      this->externalClock.align(this->songTick, this->headerChunk.headerDiv);
+    }
+    return true;
+  case (MIDI_CONTINUE):
+    if (loaded) {
+      followClock();
+    }
+    this->externalClock.resume();
+    return true;
+  // devices following our song through our thru are silenced along with our steppers
+  case (MIDI_STOP):
+    if (loaded) {
+      followClock();
+      silenceSteppers();
+      silenceThru(this->thruChannels);
+    }
+    this->externalClock.stop();
+    return false;
+  }
+  return false;
+}
+
+void midiFile::dispatchEvents(void) {
+  this->dispatching = true;
+
+  // every event due now shares our batch, so chords start together
+  // our window is left alone while our loop rewinds our song
+  beginNoteBatch();
+  while (this->playing && !this->rewindPending) {
+    // take our next event from our lookahead window once we've played the last
+    // we check whether more events are coming before we look, so that
+    // an event pushed just after we looked can't be mistaken for the end of our song
+    if (!this->eventPending) {
+      const bool moreEvents = this->eventsRemaining;
+      this->eventPending = this->lookahead.pop(this->pendingEvent);
+      if (!this->eventPending) {
+        if (!moreEvents) {
+          this->playing = false;
           break;
         }
-        else if ((trackData[j].eventType & 0xF0) == MIDI_NOTE_ON && trackData[j].track == noteOn->track) {
-          intersectingNoteOns.push_back(&trackData[j]);
-        }
+        this->playStats.underruns++;
+        esp_timer_start_once(this->playbackTimer, MIDI_UNDERRUN_RETRY);
+        break;
       }
-      // If the average overlap duration is larger than a threshold, then the track is polyphonic
-      uint32_t overlapAvg = 0;
-      for (const midiFile::midiEvent* event : intersectingNoteOns) {
-        overlapAvg += (noteOff->deltaTime - event->deltaTime) / intersectingNoteOns.size();
+      this->songTick += this->pendingEvent.deltaTime;
+    }
+
+    // a tempo change takes effect at its own tick, which every event before it
+    // has already been played by, so it is applied straight away
+    if (this->pendingEvent.eventKind == PLAYBACK_TEMPO) {
+      this->songTempos.addTempo(this->songTick, (this->pendingEvent.note << 16) | (this->pendingEvent.velocity << 8) | this->pendingEvent.channel);
+      this->songTempos.discardHistory();
+      this->eventPending = false;
+      continue;
+    }
+
+    // while following our master, our event is due when its clock says it is
+    // but is never played before the clock it falls after has arrived
+    // otherwise our song is timed from its first event by its own tempo
+    const int64_t now = esp_timer_get_time();
+    int64_t due = now;
+    if (this->slaved) {
+      if (!this->externalClock.isRunning() || !this->externalClock.reaches(this->songTick, this->headerChunk.headerDiv)) {
+        break;
       }
-      if (overlapAvg > scientificallyChosenOverlapThreshold) {
-        trackPolyphony[noteOn->track] = true;
+      due = this->externalClock.dueTime(this->songTick, this->headerChunk.headerDiv);
+    }
+    else if (this->songStarted) {
+      due = this->songStart + this->songTempos.toMicros(this->songTick);
+    }
+    else if (this->pendingEvent.eventKind != PLAYBACK_REST) {
+      this->songStart = now - this->songTempos.toMicros(this->songTick);
+    }
+
+    // if our event isn't due yet, wait for it
+    if (due > now) {
+      esp_timer_start_once(this->playbackTimer, due - now);
+      break;
+    }
+    this->eventPending = false;
+    if (this->pendingEvent.eventKind == PLAYBACK_REST) {
+      continue;
+    }
+    this->songStarted = true;
+
+    const uint32_t lateness = now - due;
+    this->playStats.eventsPlayed++;
+    this->playStats.totalLateness += lateness;
+    this->playStats.minLateness = std::min(this->playStats.minLateness, lateness);
+    this->playStats.maxLateness = std::max(this->playStats.maxLateness, lateness);
+    uint8_t event = this->pendingEvent.channel;
+    uint8_t stepperIdx = NOT_FOUND;
+    switch (this->pendingEvent.eventKind) {
+    case (PLAYBACK_PITCH_BEND):
+      event |= MIDI_PITCH_BEND;
+      pitchBend(this->pendingEvent.channel, (this->pendingEvent.velocity << 7) | this->pendingEvent.note);
+      break;
+    case (PLAYBACK_CONTROL):
+      event |= MIDI_CONTROL_CHANGE;
+      controlChange(this->pendingEvent.channel, this->pendingEvent.note, this->pendingEvent.velocity);
+      break;
+    default:
+      event |= (this->pendingEvent.eventKind == PLAYBACK_NOTE_ON) ? MIDI_NOTE_ON : MIDI_NOTE_OFF;
+      stepperIdx = playNote(this->pendingEvent.note, this->pendingEvent.velocity, event, trackProfiles[this->pendingEvent.track].polyphonic);
+      this->thruChannels |= 1 << this->pendingEvent.channel;
+      break;
+    }
+
+    // every event is echoed, including notes our steppers had no room for
+    sendThru(event, this->pendingEvent.note, this->pendingEvent.velocity);
+    traceEvent(now, event, this->pendingEvent.note, stepperIdx, lateness);
+  }
+  commitNoteBatch();
+  this->dispatching = false;
+  return;
+}
+
+void midiFile::dispatchControl(void) {
+  // our song may have been stopped since our timer last fired
+  // in which case our steppers have already been silenced
+  this->dispatching = true;
+  if (this->playing || this->liveInput) {
+    updateModulation();
+  }
+
+  // a master whose clock has gone quiet without sending stop is treated as if it had
+  // so that our song doesn't sit on the notes it was playing forever
+  if (this->slaved && this->externalClock.isRunning() && !this->externalClock.present(esp_timer_get_time())) {
+    this->externalClock.stop();
+    this->externalClock.unlock();
+    if (this->playing) {
+      silenceSteppers();
+      silenceThru(this->thruChannels);
+    }
+  }
+  this->dispatching = false;
+  return;
+}
+
+void midiFile::dispatchLive(void) {
+  liveMessage message;
+  uint8_t stepperIdx = NOT_FOUND;
+  bool clocked = false;
+
+  // every message that arrived together shares our batch, so chords start together
+  beginNoteBatch();
+  while (popLiveMessage(message)) {
+    const uint8_t channel = message.status & 0x0F;
+    switch (message.status & 0xF0) {
+    case (MIDI_NOTE_ON):
+      if (message.data2 == 0) {
+        playNote(message.data1, 0, MIDI_NOTE_OFF | channel, true);
+        break;
       }
+      stepperIdx = playNote(message.data1, message.data2, message.status, true);
+      if (LATENCY_PROFILE && stepperIdx != NOT_FOUND) {
+        latencyAllocated(stepperIdx, message.timestamp, isNoteStarting(stepperIdx));
+      }
+      break;
+    case (MIDI_NOTE_OFF):
+      playNote(message.data1, message.data2, message.status, true);
+      break;
+    case (MIDI_PITCH_BEND):
+      pitchBend(channel, (message.data2 << 7) | message.data1);
+      break;
+    case (MIDI_CONTROL_CHANGE):
+      controlChange(channel, message.data1, message.data2);
+      break;
+    // our parser passes on realtime messages and system common ones
+    // only realtime messages drive our transport. system common messages such as
+    // song position and song select are only echoed, since our songs can't seek
+    case (0xF0):
+      if (message.status >= MIDI_REALTIME) {
+        clocked |= applyTransport(message);
+      }
+      break;
+    }
+
+    // our live messages are merged with our song's events once they've been played
+    // so that echoing them never holds up our steppers
+    sendThru(message.status, message.data1, message.data2);
+  }
+  commitNoteBatch();
+
+  // our master's clock may have brought the next events of our song due
+  if (clocked && this->slaved && this->playing) {
+    esp_timer_stop(this->playbackTimer);
+    dispatchEvents();
+  }
+  return;
+}
+
+void midiFile::finishPlayback(void) {
+  stopControl();
+
+  // a song stopped part way through never recorded its watermarks
+  if (this->eventsRemaining) {
+    recordWatermarks();
+  }
+  if (SERIAL_DEBUG) {
+    printPlayback();
+    printVoiceStats();
+    printThruStats();
+  }
+  releaseEvents();
+  this->songLoaded = false;
+  return;
+}
+
+void midiFile::analyzeOverlaps(const std::deque<midiFile::midiEvent>& trackData) {
+  uint64_t tick = 0;
+
+  // our events are already in time order, so each tempo change
+  // is added to our tempo map before any event that it affects
+  this->tempos.reset(this->headerChunk.headerDiv);
+  beginAnalysis();
+  for (const midiEvent& event : trackData) {
+    tick += event.deltaTime;
+    if (event.eventType == MIDI_META_EVENT) {
+      this->tempos.addTempo(tick, event.eventData);
+      continue;
     }
+    analyzeEvent(event, this->tempos.toMicros(tick));
   }
+  this->stats.songLength = this->tempos.toMicros(tick);
+  this->voiceStates.clear();
+  this->voiceStates.shrink_to_fit();
+  return;
+}
+
+void midiFile::beginAnalysis(void) {
+  this->trackProfiles.assign(this->headerChunk.headerTrackNum, trackProfile());
+  this->voiceStates.assign(this->headerChunk.headerTrackNum, voiceState());
+  return;
+}
+
+void midiFile::analyzeEvent(const midiEvent& event, const uint64_t micros) {
+  const uint8_t note = event.eventData & 0x7F;
+  if (event.track >= this->voiceStates.size() || !(((event.eventType & 0xF0) == MIDI_NOTE_ON) || ((event.eventType & 0xF0) == MIDI_NOTE_OFF))) {
+    return;
+  }
+  voiceState& state = this->voiceStates[event.track];
+  trackProfile& profile = this->trackProfiles[event.track];
+
+  // any time that passed while more than one note was sounding
+  // counts towards the overlap of every note that was sounding
+  if (state.active > 1) {
+    profile.overlapTime += (micros - state.lastChange) * state.active;
+  }
+  state.lastChange = micros;
+
+  if ((event.eventType & 0xF0) == MIDI_NOTE_ON) {
+    profile.noteCount++;
+    if (state.notes[note] < UINT8_MAX && state.active < UINT8_MAX) {
+      state.notes[note]++;
+      state.active++;
+    }
+    profile.maxVoices = std::max(profile.maxVoices, state.active);
+  }
+
+  // note off events without a matching note on are ignored
+  else if (state.notes[note] > 0) {
+    state.notes[note]--;
+    state.active--;
+  }
+
+  // our average overlap per note is compared without dividing
+  profile.polyphonic = profile.overlapTime > (uint64_t)MIDI_POLYPHONY_THRESHOLD * profile.noteCount;
+  return;
+}
+
+void midiFile::beginStats(void) {
+  this->stats = parseStats();
+  this->stats.parseTime = micros();
+  return;
+}
+
+void midiFile::endStats(void) {
+  this->stats.parseTime = micros() - this->stats.parseTime;
+  return;
+}
+
+void midiFile::printStats(void) {
+  // guard against dividing by zero for files parsed in under a microsecond
+  const uint32_t parseTime = std::max<uint32_t>(this->stats.parseTime, 1);
+  Serial.print("Parse time in uS: ");
+  Serial.print(this->stats.parseTime);
+  Serial.print(" | Bytes: ");
+  Serial.print(this->stats.bytesRead);
+  Serial.print(" | Events: ");
+  Serial.print(this->stats.eventsRead);
+  Serial.print(" | Bytes/s: ");
+  Serial.print((uint32_t)((uint64_t)this->stats.bytesRead * 1000000 / parseTime));
+  Serial.print(" | Events/s: ");
+  Serial.println((uint32_t)((uint64_t)this->stats.eventsRead * 1000000 / parseTime));
+  Serial.print("Song length in mS: ");
+  Serial.println((uint32_t)(this->stats.songLength / 1000));
+  return;
+}
+
+const parseStats& midiFile::getStats(void) const {
+  return this->stats;
+}
+
+void midiFile::printPlayback(void) {
+  // guard against dividing by zero for songs without a single note
+  const uint32_t eventsPlayed = std::max<uint32_t>(this->playStats.eventsPlayed, 1);
+  Serial.print("Events played: ");
+  Serial.print(this->playStats.eventsPlayed);
+  Serial.print(" | Underruns: ");
+  Serial.println(this->playStats.underruns);
+  Serial.print("Lateness in uS | Min: ");
+  Serial.print((this->playStats.eventsPlayed == 0) ? 0 : this->playStats.minLateness);
+  Serial.print(" | Avg: ");
+  Serial.print((uint32_t)(this->playStats.totalLateness / eventsPlayed));
+  Serial.print(" | Max: ");
+  Serial.println(this->playStats.maxLateness);
+  Serial.print("Lookahead events held | Low: ");
+  Serial.print(this->playStats.lookaheadLow);
+  Serial.print(" | High: ");
+  Serial.print(this->playStats.lookaheadHigh);
+  Serial.print(" of ");
+  Serial.println(MIDI_LOOKAHEAD);
+  if (this->slaved) {
+    Serial.print("Followed an external clock | Last tempo in uS per quarter note: ");
+    Serial.println(this->externalClock.getTempo());
+  }
+  return;
 }
 
 void midiFile::printQueue(void) {
-  uint32_t deltaTime = 0;
+  uint64_t deltaTime = 0;
+  const std::array<uint32_t, MIDI_NOTE_COUNT>& noteFreq = midi::freqTable();
   Serial.print("Header Data: ");
   Serial.print("Format: ");
   Serial.print(this->headerChunk.headerFormat);
@@ -314,37 +1217,65 @@ void midiFile::printQueue(void) {
   Serial.print(this->headerChunk.headerTrackNum);
   Serial.print(" | Tickdiv: ");
   Serial.println(this->headerChunk.headerDiv, HEX);
+  if (this->eventQueue == NULL) {
+    Serial.println("Events are parsed incrementally during playback.");
+    return;
+  }
   Serial.print("Queue Size: ");
   Serial.println(this->eventQueue->size());
   for (uint32_t i = 0; i < this->eventQueue->size(); i++) {
+    const playbackEvent& event = (*this->eventQueue)[i];
+    deltaTime += event.deltaTime;
     Serial.print(i + 1);
-    Serial.print(" | Delta Time in uS: ");
-    Serial.print(this->eventQueue->front().deltaTime);
-    deltaTime += this->eventQueue->front().deltaTime;
+    Serial.print(" | Delta Time in ticks: ");
+    Serial.print(event.deltaTime);
+    if (event.eventKind == PLAYBACK_REST) {
+      Serial.println(" | Rest");
+      continue;
+    }
+    if (event.eventKind == PLAYBACK_TEMPO) {
+      Serial.print(" | Tempo in uS per quarter note: ");
+      Serial.println((event.note << 16) | (event.velocity << 8) | event.channel);
+      continue;
+    }
+    if (event.eventKind == PLAYBACK_PITCH_BEND) {
+      Serial.print(" | Pitch Bend: ");
+      Serial.print((event.velocity << 7) | event.note);
+      Serial.print(" | Channel: ");
+      Serial.println(event.channel);
+      continue;
+    }
+    if (event.eventKind == PLAYBACK_CONTROL) {
+      Serial.print(" | Controller: ");
+      Serial.print(event.note);
+      Serial.print(" | Value: ");
+      Serial.print(event.velocity);
+      Serial.print(" | Channel: ");
+      Serial.println(event.channel);
+      continue;
+    }
     Serial.print(" | Note in mHz: ");
-    Serial.print(this->eventQueue->front().eventData);
+    Serial.print(noteFreq[event.note]);
     Serial.print(" | Event: ");
-    Serial.print((this->eventQueue->front().getEventOrChannel(true) == MIDI_NOTE_OFF) ? "Note Off" : "Note On");
+    Serial.print((event.eventKind == PLAYBACK_NOTE_OFF) ? "Note Off" : "Note On");
     Serial.print(" | Channel: ");
-    Serial.println(this->eventQueue->front().getEventOrChannel(false));
-    this->eventQueue->push(this->eventQueue->front());
-    this->eventQueue->pop();
+    Serial.println(event.channel);
   }
   Serial.print("\nDelta Time Total: ");
-  Serial.println(deltaTime);
-  return;
-}
+  Serial.println((uint32_t)deltaTime);
 
-uint32_t midi::getFreq(const uint8_t note) {
-  uint8_t index = (note & 0x7F) % noteFreq.size();
-  int8_t octave = (note / noteFreq.size()) - 1;
-  if (octave > MIDI_OCTAVE_MAX) {
-    octave = MIDI_OCTAVE_MAX;
-  }
-  else if (octave < MIDI_OCTAVE_MIN) {
-    octave = MIDI_OCTAVE_MIN;
-  }
-  return (noteFreq[index] * pow(2, octave));
+  // report how much memory our event queue takes up, and how much
+  // the same events would have taken up in our parsing format
+  Serial.print("Event Queue Memory in Bytes: ");
+  Serial.print(this->eventQueue->capacity() * sizeof(playbackEvent));
+  Serial.print(" (");
+  Serial.print(sizeof(playbackEvent));
+  Serial.print(" per event) | Unpacked Equivalent: ");
+  Serial.print(this->eventQueue->size() * sizeof(midiEvent));
+  Serial.print(" (");
+  Serial.print(sizeof(midiEvent));
+  Serial.println(" per event)");
+  return;
 }
 
 uint8_t midiFile::midiEvent::getEventOrChannel(bool event) {
@@ -0,0 +1,247 @@
+#include "sdio-recorder.hpp"
+#include "midi.hpp"
+#include "sdio.hpp"
+#include "sdio-directoryContents.hpp"
+#include <esp_timer.h>
+
+midiRecorder recorder;
+
+bool midiRecorder::start(const std::string& dirPath) {
+  if (this->recording || this->writeTask != NULL) {
+    return false;
+  }
+
+  // our recording takes the first name in our directory that isn't already taken
+  sdGuard guard;
+  const std::string dir = (dirPath.back() == '/') ? dirPath : dirPath + "/";
+  // room for the widest number our counter can hold, along with our extension
+  char fileName[sizeof(RECORD_NAME) + 5 + 4];
+  uint16_t number = 0;
+  do {
+    snprintf(fileName, sizeof(fileName), RECORD_NAME "%03u.mid", number);
+    this->path = dir + fileName;
+  } while (sd.exists(this->path.c_str()) && ++number < RECORD_NAME_LIMIT);
+  if (number == RECORD_NAME_LIMIT || !this->file.open(this->path.c_str(), O_RDWR | O_CREAT | O_EXCL)) {
+    if (SERIAL_DEBUG) {
+      Serial.println("Failed to create recording.");
+    }
+    return false;
+  }
+
+  // a card too full or fragmented to preallocate is still recorded to
+  // but its writes may stall while free clusters are found
+  if (!this->file.preAllocate(RECORD_PREALLOCATE) && SERIAL_DEBUG) {
+    Serial.println("Failed to preallocate recording. Writes may stall.");
+  }
+
+  this->messages.clear();
+  this->sectorUsed = 0;
+  this->fileUsed = 0;
+  this->elapsed = 0;
+  this->lastTick = 0;
+  this->runningStatus = 0;
+  this->written = 0;
+  this->dropped = 0;
+  this->writeFailed = false;
+  this->finishing = false;
+  this->finished = false;
+  writeHeader();
+
+  // our recording is timed from now, not from its first message
+  this->lastTimestamp = esp_timer_get_time();
+  this->recording = true;
+  BaseType_t success = xTaskCreatePinnedToCore(writeLoop, "Recorder", RECORD_STACK, this, RECORD_PRIORITY, &this->writeTask, RECORD_CORE);
+  if (!success) {
+    if (SERIAL_DEBUG) {
+      Serial.println("Failed to create recorder task. Aborting.");
+    }
+    this->recording = false;
+    this->writeTask = NULL;
+    this->file.close();
+    sd.remove(this->path.c_str());
+    return false;
+  }
+  if (SERIAL_DEBUG) {
+    Serial.print("Recording to ");
+    Serial.println(this->path.c_str());
+  }
+  return true;
+}
+
+void midiRecorder::stop(void) {
+  if (this->writeTask == NULL) {
+    return;
+  }
+
+  // our writing task drains what is left in our queue before it finishes
+  this->recording = false;
+  this->finishing = true;
+  xTaskNotifyGive(this->writeTask);
+  while (!this->finished) {
+    delay(1);
+  }
+  this->writeTask = NULL;
+
+  {
+    sdGuard guard;
+    finishFile();
+    this->file.close();
+  }
+  if (SERIAL_DEBUG) {
+    Serial.print(this->writeFailed ? "Recording failed: " : "Recorded: ");
+    Serial.print(this->path.c_str());
+    Serial.print(" | Messages: ");
+    Serial.print(this->written);
+    Serial.print(" | Dropped: ");
+    Serial.print((uint32_t)this->dropped);
+    Serial.print(" | Bytes: ");
+    Serial.print(this->fileUsed);
+    Serial.print(" | Queue high watermark: ");
+    Serial.print(this->messages.highWatermark());
+    Serial.print(" of ");
+    Serial.println(RECORD_QUEUE);
+  }
+  return;
+}
+
+bool midiRecorder::isRecording(void) const {
+  return this->recording;
+}
+
+void midiRecorder::record(const liveMessage& message) {
+  if (this->recording && !this->messages.push(message)) {
+    this->dropped++;
+  }
+  return;
+}
+
+void midiRecorder::writeLoop(void* pvParameters) {
+  midiRecorder* recorder = static_cast<midiRecorder*>(pvParameters);
+  while (!recorder->finishing) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RECORD_PERIOD));
+    recorder->drainMessages();
+  }
+  recorder->drainMessages();
+  recorder->finished = true;
+  vTaskDelete(nullptr);
+}
+
+void midiRecorder::drainMessages(void) {
+  liveMessage message;
+  while (this->messages.pop(message)) {
+    // system messages such as our master's clock have no place in our file
+    if (message.status >= MIDI_SYSEX_START) {
+      continue;
+    }
+
+    // a message stamped just before our recording started can still reach our queue
+    // and is placed at our start rather than wrapping around to the far future
+    const int32_t delta = (int32_t)(message.timestamp - this->lastTimestamp);
+    if (delta > 0) {
+      this->elapsed += delta;
+      this->lastTimestamp = message.timestamp;
+    }
+
+    // each tick is worked out from the start of our recording
+    // so that rounding never builds up from one event to the next
+    const uint64_t tick = (this->elapsed * RECORD_DIVISION) / RECORD_TEMPO;
+    writeVariableLen(tick - this->lastTick);
+    this->lastTick = tick;
+    if (message.status != this->runningStatus) {
+      writeByte(message.status);
+      this->runningStatus = message.status;
+    }
+    writeByte(message.data1);
+
+    // program changes and channel pressure carry a single data byte
+    if ((message.status & 0xF0) != 0xC0 && (message.status & 0xF0) != 0xD0) {
+      writeByte(message.data2);
+    }
+    this->written++;
+  }
+  return;
+}
+
+void midiRecorder::writeByte(const uint8_t byte) {
+  this->sector[this->sectorUsed++] = byte;
+  if (this->sectorUsed == RECORD_SECTOR) {
+    flushSector();
+  }
+  return;
+}
+
+void midiRecorder::writeVariableLen(const uint32_t value) {
+  // seven bits are written at a time, most significant first
+  // with every byte but our last having its top bit set
+  uint8_t shift = 28;
+  while (shift > 0 && (value >> shift) == 0) {
+    shift -= 7;
+  }
+  while (shift > 0) {
+    writeByte(((value >> shift) & 0x7F) | 0x80);
+    shift -= 7;
+  }
+  writeByte(value & 0x7F);
+  return;
+}
+
+void midiRecorder::flushSector(void) {
+  if (!this->writeFailed) {
+    sdGuard guard;
+    this->writeFailed = (this->file.write(this->sector.data(), this->sectorUsed) != this->sectorUsed);
+    this->fileUsed += this->sectorUsed;
+  }
+  this->sectorUsed = 0;
+  return;
+}
+
+void midiRecorder::writeHeader(void) {
+  static const uint8_t header[] = {
+    'M', 'T', 'h', 'd', 0, 0, 0, HEADER_LEN,
+    0, 0, 0, 1, (RECORD_DIVISION >> 8) & 0xFF, RECORD_DIVISION & 0xFF,
+    'M', 'T', 'r', 'k', 0, 0, 0, 0,
+    0, MIDI_META_EVENT, MIDI_META_TEMPO, 3, (RECORD_TEMPO >> 16) & 0xFF, (RECORD_TEMPO >> 8) & 0xFF, RECORD_TEMPO & 0xFF
+  };
+  for (const uint8_t byte : header) {
+    writeByte(byte);
+  }
+  return;
+}
+
+void midiRecorder::finishFile(void) {
+  static const uint8_t endOfTrack[] = { 0, MIDI_META_EVENT, MIDI_META_EOT, 0 };
+  for (const uint8_t byte : endOfTrack) {
+    writeByte(byte);
+  }
+  flushSector();
+  if (this->writeFailed) {
+    return;
+  }
+
+  // our track's length was left as 0 when our header was written
+  // and is everything after our track chunk's type and length
+  const uint32_t trackLength = this->fileUsed - (8 + HEADER_LEN + 8);
+  const uint8_t length[] = { (uint8_t)(trackLength >> 24), (uint8_t)(trackLength >> 16), (uint8_t)(trackLength >> 8), (uint8_t)trackLength };
+  this->writeFailed = !this->file.seekSet(8 + HEADER_LEN + 4)
+                      || this->file.write(length, sizeof(length)) != sizeof(length)
+                      || !this->file.seekSet(this->fileUsed)
+                      || !this->file.truncate();
+  return;
+}
+
+void handleRecordCommand(const char command) {
+  if (command != RECORD_COMMAND) {
+    return;
+  }
+  if (!recorder.isRecording()) {
+    recorder.start(myDir.getDirPath());
+    return;
+  }
+
+  // our recording shows up in our directory once it is finished
+  // our writing task needs our SD card to finish, so it isn't guarded until then
+  recorder.stop();
+  sdGuard guard;
+  readDirectoryContents();
+  return;
+}
@@ -0,0 +1,73 @@
+#include "sdio-songCache.hpp"
+#include "globals.hpp"
+#include "midi.hpp"
+#include "sdio.hpp"
+
+// fills in the parts of our header that describe the song passed in
+// returns false if the song's modification time couldn't be read
+bool describeSong(FsFile& song, songCacheHeader& header) {
+  header.sourceSize = song.fileSize();
+  return song.getModifyDateTime(&header.sourceDate, &header.sourceTime);
+}
+
+std::string songCachePath(const std::string& songPath) {
+  // 32 bit FNV-1a hash of our song's full path
+  uint32_t hash = 2166136261u;
+  char fileName[sizeof(SONG_CACHE_DIR) + 13];
+  for (const char c : songPath) {
+    hash = (hash ^ (uint8_t)c) * 16777619u;
+  }
+  snprintf(fileName, sizeof(fileName), SONG_CACHE_DIR "/%08x.bin", (unsigned int)hash);
+  return std::string(fileName);
+}
+
+bool loadSongCache(FsFile& song, const std::string& songPath) {
+  FsFile cacheFile;
+  songCacheHeader expected, header;
+  if (!describeSong(song, expected) || !cacheFile.open(songCachePath(songPath).c_str(), SD_FILE_READ)) {
+    return false;
+  }
+
+  // our cache is only valid if it was written in the current layout
+  // and our song hasn't changed since the cache was written
+  bool valid = (cacheFile.read(&header, sizeof(header)) == sizeof(header))
+               && header.magic == expected.magic && header.version == expected.version
+               && header.sourceSize == expected.sourceSize
+               && header.sourceDate == expected.sourceDate && header.sourceTime == expected.sourceTime
+               && songData.loadEvents(cacheFile, song);
+  cacheFile.close();
+
+  // our song is left where it started, ready to be parsed if our cache wasn't valid
+  // and a cache that is out of date is removed rather than left to be read again
+  song.seekSet(0);
+  if (!valid) {
+    sd.remove(songCachePath(songPath).c_str());
+  }
+  if (SERIAL_DEBUG) {
+    Serial.println(valid ? "Loaded song from cache." : "Song cache is out of date.");
+  }
+  return valid;
+}
+
+bool saveSongCache(FsFile& song, const std::string& songPath) {
+  FsFile cacheFile;
+  songCacheHeader header;
+  if (!describeSong(song, header) || !cacheFile.open(songCachePath(songPath).c_str(), O_RDWR | O_CREAT | O_TRUNC)) {
+    return false;
+  }
+
+  // our header is written as a blank first and only filled in
+  // once the rest of our cache has been written successfully
+  // so that a cache interrupted partway through is never trusted
+  songCacheHeader blank;
+  blank.magic = 0;
+  bool success = (cacheFile.write(&blank, sizeof(blank)) == sizeof(blank))
+                 && songData.saveEvents(cacheFile)
+                 && cacheFile.seekSet(0)
+                 && (cacheFile.write(&header, sizeof(header)) == sizeof(header));
+  cacheFile.close();
+  if (SERIAL_DEBUG) {
+    Serial.println(success ? "Saved song to cache." : "Failed to save song to cache.");
+  }
+  return success;
+}
@@ -2,8 +2,10 @@
 #include "globals.hpp"
 #include "midi.hpp"
 #include "rotary.hpp"
+#include "midi-byteSource.hpp"
 #include "sdio-directoryContents.hpp"
-#include <queue>
+#include "sdio-songCache.hpp"
+#include <algorithm>
 
 // this file object is used to open and access the contents of our selected file
 FsFile loadedFile;
@@ -11,7 +13,23 @@ FsFile loadedFile;
 // this object is used to initialize and access the contents of our SD card
 SdFs sd;
 
+// held by whichever task is using our SD card through an sdGuard
+SemaphoreHandle_t sdMutex = NULL;
+
+sdGuard::sdGuard(void) {
+  xSemaphoreTakeRecursive(sdMutex, portMAX_DELAY);
+}
+
+sdGuard::~sdGuard(void) {
+  xSemaphoreGiveRecursive(sdMutex);
+}
+
 bool initializeSDCard(void) {
+  // our mutex is created by our first call, from setup, before any other task uses our card
+  if (sdMutex == NULL) {
+    sdMutex = xSemaphoreCreateRecursiveMutex();
+  }
+  sdGuard guard;
   if (SERIAL_DEBUG) {
     Serial.print("initializing SD card...");
   }
@@ -21,9 +39,9 @@ bool initializeSDCard(void) {
     }
     return false;
   }
-  if (!sd.exists("/.midi")) {
-    sd.mkdir("/.midi");
-    makeDirHidden("/.midi");
+  if (!sd.exists(SONG_CACHE_DIR)) {
+    sd.mkdir(SONG_CACHE_DIR);
+    makeDirHidden(SONG_CACHE_DIR);
   }
   if (SERIAL_DEBUG) {
     Serial.println("initialization done.");
@@ -72,6 +90,7 @@ void readDirectoryContents(void) {
 }
 
 void navigateDirectories(void) {
+  sdGuard guard;
   uint8_t lockedEncoderValue = prevEncoderValue;
 
   // ensure that our encoder isn't pointing to a file object that doesn't exist
@@ -126,7 +145,8 @@ void makeDirHidden(const std::string& dirName) {
 }
 
 bool querySD(void) {
-  if (!sd.exists("/.midi")) {
+  sdGuard guard;
+  if (!sd.exists(SONG_CACHE_DIR)) {
     sd.end();
     return false;
   }
@@ -137,20 +157,94 @@ bool querySD(void) {
 
 void openMidi(const uint8_t index) {
   FsFile dir;
-  std::queue<uint8_t>* fileContents = new std::queue<uint8_t>;
+  bool parsed = false;
+  unsigned long loadTime = micros();
+  // any song still playing is stopped before we begin on our new one
+  stopPlayback();
+
+  // our heap is measured against a baseline taken before loading begins
+  // its low water mark covers our whole uptime, so it only tells us the peak
+  // of our load if our load is what lowered it
+  const uint32_t freeHeap = ESP.getFreeHeap();
+  const uint32_t minFreeHeap = ESP.getMinFreeHeap();
+  const std::string songPath = myDir.getDirPath() + myDir.contents[index];
   dir.open(myDir.getDirPath().c_str());
   loadedFile.open(&dir, myDir.contents[index].c_str(), SD_FILE_READ);
-  while (loadedFile.peek() != -1) {
-    fileContents->push((uint8_t)loadedFile.read());
+
+  // if we've played this song before, its parsed events
+  // are waiting for us in our cache and we can skip parsing entirely
+  const bool cached = loadSongCache(loadedFile, songPath);
+  if (cached) {
+    parsed = true;
   }
-  loadedFile.close();
-  songData.assignQueue(fileContents);
-  if (!songData.parseMidi()) {
+
+  // otherwise, either parse our file a little at a time as it plays,
+  // stream our file from our SD card as it is parsed
+  // or load the whole file into memory first and parse it from there
+  else if (SD_INCREMENTAL_MIDI) {
+    parsed = songData.parseMidiIncremental(&loadedFile);
+  }
+  else if (SD_STREAM_MIDI) {
+    fileByteSource fileContents(&loadedFile);
+    songData.assignSource(&fileContents);
+    parsed = songData.parseMidi();
+  }
+  else {
+    queueByteSource fileContents;
+    fileContents.loadFile(loadedFile);
+    songData.assignSource(&fileContents);
+    parsed = songData.parseMidi();
+  }
+  if (parsed && !cached && !SD_INCREMENTAL_MIDI) {
+    saveSongCache(loadedFile, songPath);
+  }
+
+  if (SERIAL_DEBUG) {
+    // report how long it took to load and parse our file, as well as
+    // how much of our heap our song holds and the most our load used at once
+    const uint32_t freeAfter = ESP.getFreeHeap();
+    const uint32_t minFreeAfter = ESP.getMinFreeHeap();
+    Serial.print(cached ? "Cached" : (SD_INCREMENTAL_MIDI ? "Incremental" : (SD_STREAM_MIDI ? "Streamed" : "Queued")));
+    Serial.print(" load and parse time in uS: ");
+    Serial.print(micros() - loadTime);
+    Serial.print(" | Free heap before: ");
+    Serial.print(freeHeap);
+    Serial.print(" | Heap held by song: ");
+    Serial.print((int32_t)(freeHeap - freeAfter));
+    Serial.print(minFreeAfter < minFreeHeap ? " | Peak heap used by load: " : " | Peak heap used by load at most: ");
+    Serial.println(freeHeap - std::min(minFreeAfter, minFreeHeap));
+    if (!cached) {
+      songData.printStats();
+    }
+  }
+  if (!parsed) {
+    loadedFile.close();
     return;
   }
   if (SERIAL_DEBUG) {
     // songData.printQueue();
   }
-  songData.playMidi();
+
+  // our file must stay open during playback, as
+  // incrementally parsed songs are still being read from it
+  // it is closed by updatePlayback() once our song has finished
+  if (!songData.playMidi()) {
+    loadedFile.close();
+  }
+  return;
+}
+
+void updatePlayback(void) {
+  sdGuard guard;
+  if (!songData.updateMidi() && loadedFile.isOpen()) {
+    loadedFile.close();
+  }
+  return;
+}
+
+void stopPlayback(void) {
+  sdGuard guard;
+  songData.stopMidi();
+  loadedFile.close();
   return;
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "stepper-modulation.hpp"
+#include "midi.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+// how far our vibrato's phase moves each update, where a full cycle is 2^32
+const uint32_t vibratoStep = (uint32_t)((4294967296ULL * VIBRATO_RATE) / (1000ULL * MODULATION_RATE));
+
+// the highest pitch we can play in cents, that of midi note 127
+const int32_t pitchMax = 127 * 100;
+
+modulationEngine::modulationEngine(void) {
+  reset();
+}
+
+void modulationEngine::reset(void) {
+  this->channels.fill(channelState());
+  this->voices.fill(voicePitch());
+  this->vibratoPhase = 0;
+  return;
+}
+
+int32_t modulationEngine::channelOffset(const uint8_t channel) const {
+  const channelState& state = this->channels[channel];
+
+  // our bend is scaled from its 8192 steps either side of centre to our range
+  int32_t offset = ((int32_t)state.bend * state.bendRange) / 32;
+
+  // our vibrato follows a triangle wave from -256 to 255
+  // which is then scaled to the depth set by our mod wheel
+  if (state.modulation != 0) {
+    const int32_t phase = this->vibratoPhase >> 22;
+    const int32_t wave = ((phase < 512) ? phase : (1023 - phase)) - 256;
+    offset += wave * ((state.modulation * VIBRATO_DEPTH_MAX) / 127);
+  }
+  return offset;
+}
+
+uint32_t modulationEngine::pitchToFreq(const int32_t pitch) const {
+  const int32_t clamped = std::min(std::max(pitch, (int32_t)0), pitchMax << 8);
+  const int32_t cents = clamped >> 8;
+
+  // fractions of a cent are interpolated between neighbouring ratios
+  // our note's unfolded frequency is used, so a pitch between two notes either side
+  // of the top of our range stays between them, and only once our final
+  // frequency is known is it folded into our range
+  const uint32_t* ratio = &midi::centTable()[cents % 100];
+  const uint32_t multiplier = ratio[0] + (((ratio[1] - ratio[0]) * (clamped & 0xFF)) >> 8);
+  return midi::foldMilliHz(((uint64_t)midi::exactFreqTable()[cents / 100] * multiplier) >> 16);
+}
+
+uint32_t modulationEngine::noteOn(const uint8_t stepperIdx, const uint8_t channel, const uint8_t note, const bool glide) {
+  const channelState& state = this->channels[channel];
+  voicePitch& voice = this->voices[stepperIdx];
+  voice.channel = channel;
+  voice.target = ((int32_t)note * 100) << 8;
+
+  // we only glide from a note our stepper is still playing
+  // covering the whole distance in our channel's portamento time
+  if (glide && state.portamento && state.portamentoTime != 0) {
+    const int32_t updates = std::max((uint32_t)1, ((uint32_t)state.portamentoTime * PORTAMENTO_TIME_SCALE * 1000) / MODULATION_PERIOD);
+    voice.glideStep = std::max(std::abs(voice.target - voice.current) / updates, (int32_t)1);
+  }
+  else {
+    voice.current = voice.target;
+    voice.glideStep = 0;
+  }
+  voice.freq = pitchToFreq(voice.current + channelOffset(channel));
+  return voice.freq;
+}
+
+void modulationEngine::pitchBend(const uint8_t channel, const uint16_t value) {
+  this->channels[channel].bend = (int16_t)(value & 0x3FFF) - PITCH_BEND_CENTER;
+  return;
+}
+
+void modulationEngine::controlChange(const uint8_t channel, const uint8_t controller, const uint8_t value) {
+  channelState& state = this->channels[channel];
+  switch (controller) {
+  case (MIDI_CC_MODULATION):
+    state.modulation = value;
+    break;
+  case (MIDI_CC_PORTAMENTO_TIME):
+    state.portamentoTime = value;
+    break;
+  case (MIDI_CC_PORTAMENTO):
+    state.portamento = value >= 64;
+    break;
+
+  // our RPN number is selected one half at a time
+  case (MIDI_CC_RPN_MSB):
+    state.rpn = (state.rpn & 0x007F) | ((value & 0x7F) << 7);
+    break;
+  case (MIDI_CC_RPN_LSB):
+    state.rpn = (state.rpn & 0x3F80) | (value & 0x7F);
+    break;
+
+  // the pitch bend range is given as semitones through our data entry controller
+  // and optionally cents through its LSB
+  case (MIDI_CC_DATA_ENTRY):
+    if (state.rpn == RPN_PITCH_BEND_RANGE) {
+      state.bendRange = (value * 100) + (state.bendRange % 100);
+    }
+    break;
+  case (MIDI_CC_DATA_ENTRY_LSB):
+    if (state.rpn == RPN_PITCH_BEND_RANGE) {
+      state.bendRange = ((state.bendRange / 100) * 100) + std::min(value, (uint8_t)99);
+    }
+    break;
+
+  // our pitch bend range is kept, as general midi asks
+  case (MIDI_CC_RESET_CONTROLLERS):
+    state.bend = 0;
+    state.modulation = 0;
+    state.portamento = false;
+    state.rpn = RPN_NULL;
+    break;
+  }
+  return;
+}
+
+uint32_t modulationEngine::update(uint32_t activeMask) {
+  uint32_t changed = 0;
+  this->vibratoPhase += vibratoStep;
+  while (activeMask != 0) {
+    const uint8_t i = __builtin_ctz(activeMask);
+    activeMask &= activeMask - 1;
+    voicePitch& voice = this->voices[i];
+
+    // move our glide along, stopping once we reach our note
+    if (voice.glideStep != 0) {
+      const int32_t distance = voice.target - voice.current;
+      if (std::abs(distance) <= voice.glideStep) {
+        voice.current = voice.target;
+        voice.glideStep = 0;
+      }
+      else {
+        voice.current += (distance > 0) ? voice.glideStep : -voice.glideStep;
+      }
+    }
+
+    const uint32_t freq = pitchToFreq(voice.current + channelOffset(voice.channel));
+    if (freq != voice.freq) {
+      voice.freq = freq;
+      changed |= (1u << i);
+    }
+  }
+  return changed;
+}
+
+uint32_t modulationEngine::getFreq(const uint8_t stepperIdx) const {
+  return this->voices[stepperIdx].freq;
+}
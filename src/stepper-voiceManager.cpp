@@ -0,0 +1,172 @@
+#include "stepper-voiceManager.hpp"
+
+// one bit for each of our steppers
+const uint32_t allSteppers = (STEPPER_CHANNELS == 32) ? UINT32_MAX : ((1u << STEPPER_CHANNELS) - 1);
+
+voiceManager::voiceManager(void) {
+  this->steals.fill(0);
+  this->drops.fill(0);
+  this->availableMask = allSteppers;
+  reset();
+}
+
+void voiceManager::reset(void) {
+  this->voices.fill(voice());
+  this->freeMask = this->availableMask;
+  this->channelMasks.fill(0);
+  for (std::array<uint8_t, MIDI_NOTES>& notes : this->noteMap) {
+    notes.fill(NOT_FOUND);
+  }
+  return;
+}
+
+void voiceManager::setAvailable(const uint32_t mask) {
+  this->availableMask = mask & allSteppers;
+  reset();
+  return;
+}
+
+uint8_t voiceManager::firstStepper(const uint32_t mask) {
+  return (mask == 0) ? NOT_FOUND : __builtin_ctz(mask);
+}
+
+void voiceManager::assign(const uint8_t stepperIdx, const uint8_t channel, const uint8_t note, const uint8_t velocity) {
+  voice& current = this->voices[stepperIdx];
+  if (current.channel != NO_CHANNEL) {
+    this->channelMasks[current.channel] &= ~(1u << stepperIdx);
+    this->noteMap[current.channel][current.note] = NOT_FOUND;
+  }
+  current.channel = channel;
+  current.note = note;
+  current.velocity = velocity;
+  current.age = this->noteCount++;
+  this->freeMask &= ~(1u << stepperIdx);
+  this->channelMasks[channel] |= (1u << stepperIdx);
+  this->noteMap[channel][note] = stepperIdx;
+  return;
+}
+
+uint8_t voiceManager::oldestStepper(uint32_t mask) const {
+  uint8_t oldest = NOT_FOUND;
+  while (mask != 0) {
+    const uint8_t i = __builtin_ctz(mask);
+    if (oldest == NOT_FOUND || this->voices[i].age < this->voices[oldest].age) {
+      oldest = i;
+    }
+    mask &= mask - 1;
+  }
+  return oldest;
+}
+
+uint8_t voiceManager::chooseVictim(const uint8_t channel) const {
+  const uint32_t busy = activeMask();
+
+  // with none of our steppers available, there is nothing to steal
+  if (busy == 0) {
+    return NOT_FOUND;
+  }
+  switch (this->policy) {
+  case (VOICE_STEAL_OLDEST):
+    return oldestStepper(busy);
+
+  case (VOICE_STEAL_QUIETEST): {
+    // narrow our choice down to the quietest notes, then take the oldest of those
+    uint32_t quietest = 0;
+    uint8_t lowest = UINT8_MAX;
+    for (uint32_t mask = busy; mask != 0; mask &= mask - 1) {
+      const uint8_t i = __builtin_ctz(mask);
+      if (this->voices[i].velocity < lowest) {
+        lowest = this->voices[i].velocity;
+        quietest = 0;
+      }
+      if (this->voices[i].velocity == lowest) {
+        quietest |= (1u << i);
+      }
+    }
+    return oldestStepper(quietest);
+  }
+
+  case (VOICE_STEAL_SAME_CHANNEL):
+    return oldestStepper((this->channelMasks[channel] != 0) ? this->channelMasks[channel] : busy);
+
+  case (VOICE_STEAL_KEEP_HIGHEST): {
+    uint8_t highest = NOT_FOUND;
+    for (uint32_t mask = busy; mask != 0; mask &= mask - 1) {
+      const uint8_t i = __builtin_ctz(mask);
+      if (highest == NOT_FOUND || this->voices[i].note > this->voices[highest].note) {
+        highest = i;
+      }
+    }
+
+    // with only a single stepper, our melody has to give way
+    const uint32_t others = busy & ~(1u << highest);
+    return oldestStepper((others != 0) ? others : busy);
+  }
+
+  default:
+    return NOT_FOUND;
+  }
+}
+
+uint8_t voiceManager::noteOn(const uint8_t channel, const uint8_t note, const uint8_t velocity, const bool polyphonic) {
+  const uint8_t ch = channel & 0x0F, n = note & 0x7F;
+
+  // a note struck again while still sounding stays on the stepper it's already on
+  uint8_t stepperIdx = this->noteMap[ch][n];
+  if (stepperIdx == NOT_FOUND && !polyphonic) {
+    stepperIdx = firstStepper(this->channelMasks[ch]);
+  }
+  if (stepperIdx == NOT_FOUND) {
+    stepperIdx = firstStepper(this->freeMask);
+  }
+
+  // every stepper is busy, so a note must either be stolen or dropped
+  if (stepperIdx == NOT_FOUND) {
+    stepperIdx = chooseVictim(ch);
+    if (stepperIdx == NOT_FOUND) {
+      this->drops[this->policy]++;
+      return NOT_FOUND;
+    }
+    this->steals[this->policy]++;
+  }
+  assign(stepperIdx, ch, n, velocity);
+  return stepperIdx;
+}
+
+uint8_t voiceManager::noteOff(const uint8_t channel, const uint8_t note) {
+  const uint8_t ch = channel & 0x0F, n = note & 0x7F;
+  const uint8_t stepperIdx = this->noteMap[ch][n];
+  if (stepperIdx != NOT_FOUND) {
+    this->voices[stepperIdx].channel = NO_CHANNEL;
+    this->channelMasks[ch] &= ~(1u << stepperIdx);
+    this->noteMap[ch][n] = NOT_FOUND;
+    this->freeMask |= (1u << stepperIdx);
+  }
+  return stepperIdx;
+}
+
+uint8_t voiceManager::release(const uint8_t stepperIdx) {
+  const voice& current = this->voices[stepperIdx];
+  return (current.channel == NO_CHANNEL) ? NOT_FOUND : noteOff(current.channel, current.note);
+}
+
+uint32_t voiceManager::activeMask(void) const {
+  return ~this->freeMask & this->availableMask;
+}
+
+void voiceManager::setPolicy(const uint8_t policy) {
+  this->policy = (policy < VOICE_STEAL_POLICIES) ? policy : VOICE_STEAL_DEFAULT;
+  return;
+}
+
+uint8_t voiceManager::getPolicy(void) const {
+  return this->policy;
+}
+
+const std::array<uint32_t, VOICE_STEAL_POLICIES>& voiceManager::getSteals(void) const {
+  return this->steals;
+}
+
+const std::array<uint32_t, VOICE_STEAL_POLICIES>& voiceManager::getDrops(void) const {
+  return this->drops;
+}
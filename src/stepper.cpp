@@ -2,93 +2,201 @@
 #include "FastAccelStepper.h"
 #include "globals.hpp"
 #include "midi.hpp"
-#include <sstream>
+#include "stepper-modulation.hpp"
+#include "stepper-voiceManager.hpp"
+#include "uart-latency.hpp"
+#include <algorithm>
 // get rid of annoying library warning
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
 
-struct NoteChannel {
-  uint32_t note = 0;
-  uint8_t channel = NO_CHANNEL;
-};
-
 FastAccelStepperEngine engine = FastAccelStepperEngine();
 std::array<FastAccelStepper*, STEPPER_CHANNELS> stepper;
 
-void initializeStepper(void) {
-  const std::array<uint8_t, STEPPER_CHANNELS> mtrSteps = { MTR_STEPS };
-  engine.init();
-  stepper.fill(NULL);
-  for (uint8_t j = 0; j < STEPPER_CHANNELS; j++) {
-    stepper[j] = engine.stepperConnectToPin(mtrSteps[j]);
-    stepper[j]->setAutoEnable(true);
-    stepper[j]->setAcceleration(INT_MAX);
-    stepper[j]->applySpeedAcceleration();
+// the step pin of each of our steppers
+const uint8_t mtrSteps[] = { MTR_STEPS };
+static_assert(sizeof(mtrSteps) == STEPPER_CHANNELS, "MTR_STEPS must list exactly STEPPER_CHANNELS pins");
+
+// the driver each of our steppers was given
+std::array<uint8_t, STEPPER_CHANNELS> stepperDrivers;
+
+// decides which of our steppers plays each note
+voiceManager voices;
+
+// works out the pitch of each note from its channel's controllers
+modulationEngine modulation;
+
+// called by our stepper task each time it starts one of our steppers
+// so that the latency of live notes can be measured up to this point
+void toneStarted(FastAccelStepper* started) {
+  const auto found = std::find(stepper.begin(), stepper.end(), started);
+  if (found != stepper.end()) {
+    latencyStarted(found - stepper.begin());
   }
   return;
 }
 
-uint8_t findStepperPreferPoly(const std::array<NoteChannel, STEPPER_CHANNELS>& activeChannels, const uint8_t channel) {
-  uint8_t stepperOnChannel = NOT_FOUND;
-  for (uint8_t i = 0; i < STEPPER_CHANNELS; ++i) {
-    if (activeChannels[i].channel == NO_CHANNEL) {
-      // prefer first available stepper
-      return i;
-    }
-    if (activeChannels[i].channel == channel && stepperOnChannel == NOT_FOUND) {
-      // use already active stepper as a fallback, if one is active for this channel
-      stepperOnChannel = i;
-    }
+// connects a stepper to the pin passed in, storing the driver it was given in driver
+// returns NULL if neither of our drivers has a stepper left to give
+FastAccelStepper* connectStepper(const uint8_t pin, uint8_t& driver) {
+  FastAccelStepper* connected = NULL;
+#if defined(SUPPORT_SELECT_DRIVER_TYPE)
+  connected = engine.stepperConnectToPin(pin, DRIVER_MCPWM_PCNT);
+  driver = STEPPER_DRIVER_MCPWM_PCNT;
+  if (connected == NULL) {
+    connected = engine.stepperConnectToPin(pin, DRIVER_RMT);
+    driver = STEPPER_DRIVER_RMT;
   }
-  return stepperOnChannel;
+#else
+  // our chip only has a single driver to choose from
+  connected = engine.stepperConnectToPin(pin);
+  driver = STEPPER_DRIVER_RMT;
+#endif
+  if (connected == NULL) {
+    driver = STEPPER_DRIVER_NONE;
+  }
+  return connected;
 }
 
-uint8_t findStepperPreferMono(const std::array<NoteChannel, STEPPER_CHANNELS>& activeChannels, const uint8_t channel) {
-  uint8_t firstFound = NOT_FOUND;
-  for (uint8_t i = 0; i < STEPPER_CHANNELS; ++i) {
-    if (activeChannels[i].channel == channel) {
-      // prefer taking over an already active stepper on this channel
-      return i;
+void initializeStepper(void) {
+  static const char* driverNames[] = { "None", "MCPWM/PCNT", "RMT" };
+  uint32_t connected = 0;
+  // our stepper task shares a core with our playback task, so that
+  // every note started in one batch is picked up in the same run
+  engine.init(MIDI_PLAYBACK_CORE);
+  if (LATENCY_PROFILE) {
+    engine.setToneStartCallback(toneStarted);
+  }
+  stepper.fill(NULL);
+  for (uint8_t j = 0; j < STEPPER_CHANNELS; j++) {
+    stepper[j] = connectStepper(mtrSteps[j], stepperDrivers[j]);
+    if (SERIAL_DEBUG) {
+      Serial.print("Stepper ");
+      Serial.print(j);
+      Serial.print(" on pin ");
+      Serial.print(mtrSteps[j]);
+      Serial.print(" | Driver: ");
+      Serial.println(driverNames[stepperDrivers[j]]);
     }
-    if (activeChannels[i].channel == NO_CHANNEL && firstFound == NOT_FOUND) {
-      // use the first available stepper as a fallback
-      firstFound = i;
+    if (stepper[j] == NULL) {
+      continue;
     }
+    stepper[j]->setAutoEnable(true);
+    connected |= (1u << j);
   }
-  return firstFound;
+  voices.setAvailable(connected);
+  return;
 }
 
-uint8_t findActiveStepper(const std::array<NoteChannel, STEPPER_CHANNELS>& activeChannels, const uint32_t note, const uint8_t channel) {
-  for (uint8_t i = 0; i < STEPPER_CHANNELS; ++i) {
-    if (activeChannels[i].channel == channel && activeChannels[i].note == note) {
-      return i;
-    }
-  }
-  return NOT_FOUND;
+uint8_t getStepperDriver(const uint8_t stepperIdx) {
+  return (stepperIdx < STEPPER_CHANNELS) ? stepperDrivers[stepperIdx] : STEPPER_DRIVER_NONE;
 }
 
-void playNote(const uint32_t deltaTime, const uint32_t note, const uint8_t event, const bool polyphonic, std::stringstream& debugString) {
+uint8_t playNote(const uint8_t note, const uint8_t velocity, const uint8_t event, const bool polyphonic) {
   const uint8_t channel = (event & 0x0F), eventType = (event >> 4);
-  static std::array<NoteChannel, STEPPER_CHANNELS> activeChannels {};
-  delayMicroseconds(deltaTime);
-
   uint8_t stepperIdx = NOT_FOUND;
   if (eventType == MIDI_NOTE_ON >> 4) {
-    stepperIdx = polyphonic ? findStepperPreferPoly(activeChannels, channel) : findStepperPreferMono(activeChannels, channel);
+    // a stepper that was already sounding may glide into our new note
+    const uint32_t active = voices.activeMask();
+    stepperIdx = voices.noteOn(channel, note, velocity, polyphonic);
     if (stepperIdx != NOT_FOUND) {
-      activeChannels[stepperIdx].channel = channel;
-      activeChannels[stepperIdx].note = note;
-      stepper[stepperIdx]->setSpeedInMilliHz(note);
-      stepper[stepperIdx]->runForward();
+      // our note's period is worked out once and played without any ramp
+      // so a stolen stepper changes pitch within a few mS
+      const bool glide = (active >> stepperIdx) & 1;
+
+      // a tone our stepper refuses would never sound, so our note gives its stepper back
+      // rather than holding on to it, and whatever it was playing before is stopped
+      if (stepper[stepperIdx]->setToneInMilliHz(modulation.noteOn(stepperIdx, channel, note & 0x7F, glide)) != TONE_OK) {
+        voices.noteOff(channel, note);
+        stepper[stepperIdx]->stopTone();
+        return NOT_FOUND;
+      }
     }
   }
   else {
-    stepperIdx = findActiveStepper(activeChannels, note, channel);
+    stepperIdx = voices.noteOff(channel, note);
     if (stepperIdx != NOT_FOUND) {
-      activeChannels[stepperIdx].channel = NO_CHANNEL;
-      stepper[stepperIdx]->stopMove();
+      stepper[stepperIdx]->stopTone();
     }
   }
+  return stepperIdx;
+}
+
+bool isNoteStarting(const uint8_t stepperIdx) {
+  return stepper[stepperIdx]->isToneActive() && !stepper[stepperIdx]->isQueueRunning();
+}
+
+void pitchBend(const uint8_t channel, const uint16_t value) {
+  modulation.pitchBend(channel & 0x0F, value);
+  return;
+}
+
+void controlChange(const uint8_t channel, const uint8_t controller, const uint8_t value) {
+  modulation.controlChange(channel & 0x0F, controller, value);
+  return;
+}
+
+void updateModulation(void) {
+  // only steppers whose pitch has actually moved are retuned
+  uint32_t changed = modulation.update(voices.activeMask());
+  while (changed != 0) {
+    const uint8_t i = __builtin_ctz(changed);
+
+    // a note bent or glided beyond what our stepper can play is let go
+    if (stepper[i]->setToneInMilliHz(modulation.getFreq(i)) != TONE_OK) {
+      voices.release(i);
+      stepper[i]->stopTone();
+    }
+    changed &= changed - 1;
+  }
+  return;
+}
+
+void resetControllers(void) {
+  modulation.reset();
+  return;
+}
+
+void beginNoteBatch(void) {
+  engine.beginToneBatch();
+  return;
+}
+
+void commitNoteBatch(void) {
+  engine.commitToneBatch();
+  return;
+}
+
+void silenceSteppers(void) {
+  uint32_t active = voices.activeMask();
+  while (active != 0) {
+    stepper[__builtin_ctz(active)]->stopTone();
+    active &= active - 1;
+  }
+  voices.reset();
+  return;
+}
+
+void setStealPolicy(const uint8_t policy) {
+  voices.setPolicy(policy);
+  return;
+}
+
+void printVoiceStats(void) {
+  static const char* policyNames[VOICE_STEAL_POLICIES] = { "None", "Oldest", "Quietest", "Same Channel", "Keep Highest" };
+  Serial.print("Voice stealing policy: ");
+  Serial.println(policyNames[voices.getPolicy()]);
+  for (uint8_t i = 0; i < VOICE_STEAL_POLICIES; i++) {
+    Serial.print(policyNames[i]);
+    Serial.print(" | Steals: ");
+    Serial.print(voices.getSteals()[i]);
+    Serial.print(" | Drops: ");
+    Serial.println(voices.getDrops()[i]);
+  }
 
-  debugString << " - DeltaTime in uS: " << deltaTime << " | Event: " << (uint16_t)event << " | Note in mHz: " << note << " | Stepper Index: " << std::to_string(stepperIdx);
+  // the worst skew between notes started together, in nS
+  Serial.print("Max note onset skew: ");
+  Serial.print((uint64_t)engine.getMaxToneStartSkewInCycles() * 1000 / getCpuFrequencyMhz());
+  Serial.println("nS");
+  engine.resetMaxToneStartSkew();
   return;
 }
\ No newline at end of file
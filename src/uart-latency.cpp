@@ -0,0 +1,110 @@
+#include "uart-latency.hpp"
+
+#if LATENCY_PROFILE
+#include <esp_timer.h>
+#include <algorithm>
+
+// the latencies of each of our stages
+std::array<latencyHistogram, LATENCY_STAGES> latencies;
+
+// the time the note each stepper is waiting to start arrived over our UART
+// written by our playback task before our stepper task may start its queue
+std::array<std::atomic<uint32_t>, STEPPER_CHANNELS> pendingReceived;
+std::array<std::atomic<bool>, STEPPER_CHANNELS> pendingStart;
+
+latencyHistogram::latencyHistogram(void) {
+  this->buckets.fill(0);
+}
+
+void latencyHistogram::record(const uint32_t latency) {
+  if (this->clearPending.exchange(false)) {
+    this->buckets.fill(0);
+    this->count = 0;
+    this->total = 0;
+    this->fastest = UINT32_MAX;
+    this->slowest = 0;
+  }
+  this->buckets[std::min(latency / LATENCY_BUCKET_WIDTH, (uint32_t)LATENCY_BUCKETS - 1)]++;
+  this->count++;
+  this->total += latency;
+  this->fastest = std::min(this->fastest, latency);
+  this->slowest = std::max(this->slowest, latency);
+  return;
+}
+
+void latencyHistogram::clear(void) {
+  this->clearPending = true;
+  return;
+}
+
+void latencyHistogram::print(const char* name) const {
+  Serial.print(name);
+  if (this->count == 0) {
+    Serial.println(" | No notes measured");
+    return;
+  }
+
+  // our p99 lies in the first bucket that brings us to 99% of our latencies
+  const uint32_t target = this->count - (this->count / 100);
+  uint32_t seen = 0;
+  uint8_t p99 = 0;
+  while (seen + this->buckets[p99] < target) {
+    seen += this->buckets[p99++];
+  }
+  Serial.print(" | Notes: ");
+  Serial.print(this->count);
+  Serial.print(" | Min: ");
+  Serial.print(this->fastest);
+  Serial.print("uS | Avg: ");
+  Serial.print((uint32_t)(this->total / this->count));
+  Serial.print("uS | P99: ");
+  if (p99 == LATENCY_BUCKETS - 1) {
+    Serial.print(">");
+    Serial.print(p99 * LATENCY_BUCKET_WIDTH);
+  }
+  else {
+    Serial.print("<");
+    Serial.print((p99 + 1) * LATENCY_BUCKET_WIDTH);
+  }
+  Serial.print("uS | Max: ");
+  Serial.print(this->slowest);
+  Serial.println("uS");
+  return;
+}
+
+void latencyAllocated(const uint8_t stepperIdx, const uint32_t received, const bool starting) {
+  latencies[LATENCY_ALLOCATE].record((uint32_t)esp_timer_get_time() - received);
+
+  // a stepper that is already stepping is retuned rather than started
+  // so its commit can't be told apart from the rest of its queue
+  pendingReceived[stepperIdx] = received;
+  pendingStart[stepperIdx] = starting;
+  return;
+}
+
+void latencyStarted(const uint8_t stepperIdx) {
+  // notes from our songs start steppers too, but only live notes are measured
+  if (stepperIdx < STEPPER_CHANNELS && pendingStart[stepperIdx].exchange(false)) {
+    latencies[LATENCY_COMMIT].record((uint32_t)esp_timer_get_time() - pendingReceived[stepperIdx]);
+  }
+  return;
+}
+
+void handleLatencyCommand(const char command) {
+  static const char* stageNames[LATENCY_STAGES] = { "UART to allocation", "UART to queue start" };
+  switch (command) {
+  case (LATENCY_PRINT_COMMAND):
+    for (uint8_t i = 0; i < LATENCY_STAGES; i++) {
+      latencies[i].print(stageNames[i]);
+    }
+    break;
+  case (LATENCY_CLEAR_COMMAND):
+    for (latencyHistogram& histogram : latencies) {
+      histogram.clear();
+    }
+    Serial.println("Latency histograms cleared");
+    break;
+  }
+  return;
+}
+#endif
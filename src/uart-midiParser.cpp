@@ -0,0 +1,70 @@
+#include "uart-midiParser.hpp"
+
+bool midiParser::parse(const uint8_t byte, liveMessage& message) {
+  // realtime bytes stand alone and leave the message around them untouched
+  // 0xF9 and 0xFD are undefined, so they are dropped
+  if (byte >= MIDI_REALTIME) {
+    if (byte == 0xF9 || byte == 0xFD) {
+      return false;
+    }
+    message = { byte, 0, 0 };
+    return true;
+  }
+
+  if (byte & 0x80) {
+    // any status byte ends a system exclusive message, not only its end byte
+    this->sysex = (byte == MIDI_SYSEX_START);
+    this->dataCount = 0;
+
+    // channel messages become our running status
+    // program change and channel pressure carry a single data byte
+    if (byte < MIDI_SYSEX_START) {
+      this->status = byte;
+      this->dataNeeded = ((byte & 0xE0) == 0xC0) ? 1 : 2;
+      return false;
+    }
+
+    // every system common message cancels running status
+    this->status = 0;
+    switch (byte) {
+    case (MIDI_TIME_CODE):
+    case (MIDI_SONG_SELECT):
+      this->status = byte;
+      this->dataNeeded = 1;
+      break;
+    case (MIDI_SONG_POSITION):
+      this->status = byte;
+      this->dataNeeded = 2;
+      break;
+    case (MIDI_TUNE_REQUEST):
+      message = { byte, 0, 0 };
+      return true;
+    }
+    return false;
+  }
+
+  // data bytes belong to the message we are reading, if there is one
+  if (this->sysex || this->status == 0) {
+    return false;
+  }
+  this->data[this->dataCount++] = byte;
+  if (this->dataCount < this->dataNeeded) {
+    return false;
+  }
+  message = { this->status, this->data[0], (this->dataNeeded == 2) ? this->data[1] : (uint8_t)0 };
+  this->dataCount = 0;
+
+  // only channel messages carry their status over to the data bytes after them
+  if (this->status >= MIDI_SYSEX_START) {
+    this->status = 0;
+  }
+  return true;
+}
+
+void midiParser::reset(void) {
+  this->status = 0;
+  this->dataNeeded = 0;
+  this->dataCount = 0;
+  this->sysex = false;
+  return;
+}
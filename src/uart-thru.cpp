@@ -0,0 +1,135 @@
+#include "uart-thru.hpp"
+#include "midi.hpp"
+#include "uart-midiParser.hpp"
+#include <esp_timer.h>
+#include <algorithm>
+
+// this struct holds our thru measurements, written only by our playback task
+struct thruStats {
+  // the time our measurements were last reset according to esp_timer_get_time()
+  int64_t since = 0;
+
+  // the messages and bytes sent, and the status bytes running status left out
+  uint32_t messagesSent = 0;
+  uint32_t bytesSent = 0;
+  uint32_t bytesSaved = 0;
+
+  // the messages dropped because our transmit buffer was full
+  uint32_t messagesDropped = 0;
+};
+
+// the status byte of the last channel message we sent, or 0 if the next must send its own
+// only ever used by our playback task
+uint8_t thruStatus = 0;
+
+// the time our last message was sent according to esp_timer_get_time()
+int64_t thruLastSent = 0;
+
+thruStats thru;
+
+void initializeThru(void) {
+  Serial1.setTxBufferSize(UART_THRU_BUFFER);
+  resetThruStats();
+  return;
+}
+
+void sendThru(uint8_t status, const uint8_t data1, uint8_t data2) {
+  uint8_t message[3] = { status, data1, data2 };
+  uint8_t length = 3;
+
+  // realtime messages may be sent between any others, without disturbing our running status
+  if (status >= MIDI_REALTIME) {
+    length = 1;
+  }
+
+  // system common messages carry up to two data bytes of their own
+  // system exclusive never reaches us, as our parser and our songs pass none on
+  else if (status >= MIDI_SYSEX_START) {
+    if (status == MIDI_SONG_POSITION) {
+      length = 3;
+    }
+    else if (status == MIDI_TIME_CODE || status == MIDI_SONG_SELECT) {
+      length = 2;
+    }
+    else if (status == MIDI_TUNE_REQUEST) {
+      length = 1;
+    }
+    else {
+      return;
+    }
+  }
+  else {
+    if (UART_THRU_NOTE_OFF_AS_ON && (status & 0xF0) == MIDI_NOTE_OFF) {
+      status = MIDI_NOTE_ON | (status & 0x0F);
+      data2 = 0;
+    }
+
+    // program changes and channel pressure carry a single data byte
+    length = ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 2 : 3;
+    message[0] = status;
+    message[2] = data2;
+  }
+
+  const int64_t now = esp_timer_get_time();
+  if (now - thruLastSent > UART_THRU_STATUS_REFRESH) {
+    thruStatus = 0;
+  }
+  const bool running = (status == thruStatus);
+  const uint8_t* start = running ? &message[1] : &message[0];
+  const uint8_t size = running ? length - 1 : length;
+
+  // half a message would leave every device after us out of step
+  // so a message is only sent if all of it fits
+  if (Serial1.availableForWrite() < size) {
+    thru.messagesDropped++;
+    return;
+  }
+  Serial1.write(start, size);
+
+  // a system common message cancels running status, so the next channel message sends its own
+  if (status < MIDI_SYSEX_START) {
+    thruStatus = status;
+  }
+  else if (status < MIDI_REALTIME) {
+    thruStatus = 0;
+  }
+  thruLastSent = now;
+  thru.messagesSent++;
+  thru.bytesSent += size;
+  thru.bytesSaved += length - size;
+  return;
+}
+
+void silenceThru(const uint16_t channels) {
+  for (uint8_t channel = 0; channel < 16; channel++) {
+    if (channels & (1 << channel)) {
+      sendThru(MIDI_CONTROL_CHANGE | channel, MIDI_CC_ALL_NOTES_OFF, 0);
+    }
+  }
+  return;
+}
+
+void resetThruStats(void) {
+  thru = thruStats();
+  thru.since = esp_timer_get_time();
+  return;
+}
+
+void printThruStats(void) {
+  // guard against dividing by zero for measurements reset only just now
+  const uint32_t elapsed = std::max<int64_t>((esp_timer_get_time() - thru.since) / 1000, 1);
+  const uint32_t throughput = ((uint64_t)thru.bytesSent * 1000) / elapsed;
+  Serial.print("Thru messages sent: ");
+  Serial.print(thru.messagesSent);
+  Serial.print(" | Dropped: ");
+  Serial.print(thru.messagesDropped);
+  Serial.print(" | Bytes sent: ");
+  Serial.print(thru.bytesSent);
+  Serial.print(" | Saved by running status: ");
+  Serial.println(thru.bytesSaved);
+  Serial.print("Thru throughput in bytes per second: ");
+  Serial.print(throughput);
+  Serial.print(" of ");
+  Serial.println(UART_THRU_BYTES_PER_SECOND);
+  return;
+}
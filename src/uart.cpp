@@ -1,28 +1,52 @@
 #include "uart.hpp"
+#include "midi.hpp"
+#include "ringBuffer.hpp"
+#include "sdio-recorder.hpp"
+#include "uart-thru.hpp"
+#include <esp_timer.h>
+
+// turns the bytes arriving on our UART into complete messages
+// only ever used by our UART's event task
+midiParser liveParser;
+
+// complete messages waiting for our playback task
+// pushed only by our UART's event task and popped only by our playback task
+ringBuffer<liveMessage, UART_LIVE_QUEUE> liveMessages;
+
+// called by our UART's event task whenever bytes have arrived
+// every message they complete is queued before our playback task is woken
+// so that a chord arriving together is played together
+void receiveMIDI(void) {
+  liveMessage message;
+  bool received = false;
+  while (Serial1.available()) {
+    if (liveParser.parse(Serial1.read(), message)) {
+      message.timestamp = esp_timer_get_time();
+      received |= liveMessages.push(message);
+      recorder.record(message);
+    }
+  }
+  if (received) {
+    songData.notifyLive();
+  }
+  return;
+}
 
 void initializeUART() {
+  initializeThru();
   Serial1.begin(UART_BAUD, SERIAL_8N1, UART_RX, UART_TX);
-  pinMode(2, OUTPUT);
-  digitalWrite(2, LOW);
 
+  // our UART raises an event for every byte rather than waiting for its FIFO
+  // to fill or its line to go idle, so a message is passed on
+  // as soon as its last byte arrives
+  Serial1.setRxFIFOFull(1);
+  Serial1.onReceive(receiveMIDI);
+  if (!songData.startLive() && SERIAL_DEBUG) {
+    Serial.println("Failed to start live input.");
+  }
   return;
 }
 
-void checkMIDI() {
-  byte commandByte;
-  byte noteByte;
-  byte velocityByte;
-  do {
-    if (Serial1.available()) {
-      commandByte = Serial1.read();  // read first byte
-      noteByte = Serial1.read();     // read next byte
-      velocityByte = Serial1.read(); // read final byte
-      if (commandByte == 144){//if note on message
-        //check if note == 60 and velocity > 0
-        if (noteByte == 60 && velocityByte > 0){
-          digitalWrite(2, HIGH); //turn on led
-        }
-      }
-    }
-  } while (Serial1.available() > 2); // when at least three bytes available
-}
\ No newline at end of file
+bool popLiveMessage(liveMessage& message) {
+  return liveMessages.pop(message);
+}
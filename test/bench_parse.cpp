@@ -0,0 +1,136 @@
+// measures how quickly and in how much memory our parser turns each midi file
+// of our corpus into playback events, reporting events and bytes parsed per second
+// along with the peak heap and number of allocations made by parseMidi()
+// run with the directory holding our corpus, and optionally the number of runs per file
+#include "midi.hpp"
+#include <chrono>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <new>
+
+namespace {
+// the heap used since our counters were last reset, as seen through operator new
+struct heapCounters {
+  uint64_t allocations = 0;
+  uint64_t current = 0;
+  uint64_t peak = 0;
+  bool counting = false;
+};
+heapCounters heap;
+
+// each allocation is prefixed with its size so that our deletes can account for it
+const size_t HEADER = alignof(std::max_align_t);
+
+void* countedNew(size_t size) {
+  uint8_t* block = static_cast<uint8_t*>(malloc(size + HEADER));
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  *reinterpret_cast<size_t*>(block) = size;
+  if (heap.counting) {
+    heap.allocations++;
+    heap.current += size;
+    heap.peak = std::max(heap.peak, heap.current);
+  }
+  return block + HEADER;
+}
+
+void countedDelete(void* pointer) {
+  if (pointer == nullptr) {
+    return;
+  }
+  uint8_t* block = static_cast<uint8_t*>(pointer) - HEADER;
+  if (heap.counting) {
+    heap.current -= std::min<uint64_t>(heap.current, *reinterpret_cast<size_t*>(block));
+  }
+  free(block);
+}
+
+std::vector<std::string> listCorpus(const std::string& dirPath) {
+  std::vector<std::string> paths;
+  DIR* dir = opendir(dirPath.c_str());
+  if (dir == nullptr) {
+    return paths;
+  }
+  while (dirent* entry = readdir(dir)) {
+    const std::string name = entry->d_name;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".mid") == 0) {
+      paths.push_back(dirPath + "/" + name);
+    }
+  }
+  closedir(dir);
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+}
+
+void* operator new(size_t size) {
+  return countedNew(size);
+}
+
+void* operator new[](size_t size) {
+  return countedNew(size);
+}
+
+void operator delete(void* pointer) noexcept {
+  countedDelete(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  countedDelete(pointer);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <corpus directory> [runs per file]\n", argv[0]);
+    return 2;
+  }
+  const uint32_t runs = (argc > 2) ? std::max(atoi(argv[2]), 1) : 20;
+  const std::vector<std::string> corpus = listCorpus(argv[1]);
+  if (corpus.empty()) {
+    fprintf(stderr, "no midi files found in %s\n", argv[1]);
+    return 1;
+  }
+
+  printf("%-24s %8s %8s %12s %12s %10s %8s\n", "file", "bytes", "events", "events/s", "bytes/s", "peak heap", "allocs");
+  for (const std::string& path : corpus) {
+    std::ifstream input(path, std::ios::binary);
+    sdFiles()[path] = std::make_shared<std::vector<uint8_t>>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+    // every run parses the same file, so our heap is measured on the first
+    // and our time is the fastest of them, the one least disturbed by our host
+    double fastest = 0;
+    parseStats stats;
+    heapCounters parseHeap;
+    for (uint32_t i = 0; i < runs; i++) {
+      midiFile song;
+      FsFile file;
+      file.open(path.c_str());
+      fileByteSource source(&file);
+      song.assignSource(&source);
+
+      heap = heapCounters();
+      heap.counting = (i == 0);
+      const auto start = std::chrono::steady_clock::now();
+      const bool parsed = song.parseMidi();
+      const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (i == 0) {
+        parseHeap = heap;
+      }
+      heap.counting = false;
+      if (!parsed) {
+        fprintf(stderr, "failed to parse %s\n", path.c_str());
+        return 1;
+      }
+      fastest = (i == 0) ? elapsed : std::min(fastest, elapsed);
+      stats = song.getStats();
+    }
+
+    const std::string name = path.substr(path.find_last_of('/') + 1);
+    printf("%-24s %8u %8u %12.0f %12.0f %10llu %8llu\n", name.c_str(), stats.bytesRead, stats.eventsRead, stats.eventsRead / fastest, stats.bytesRead / fastest, (unsigned long long)parseHeap.peak, (unsigned long long)parseHeap.allocations);
+    sdFiles().erase(path);
+  }
+  return 0;
+}
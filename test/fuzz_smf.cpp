@@ -0,0 +1,198 @@
+// feeds arbitrary bytes to every part of our firmware that reads a midi file
+// parseMidi(), parseMidiIncremental() and loadEvents(), checking that each stays
+// within the bytes it was given and that parsing stays linear in their length
+// built with -DFUZZ_LIBFUZZER=ON under clang this is a libFuzzer target
+//   fuzz_smf -max_len=65536 corpus/
+// otherwise it replays our seed corpus, along with truncated and mutated copies
+// of each seed, so that our sanitizers see the same paths on every build
+#include "midi.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+
+namespace {
+const char* FUZZ_PATH = "/fuzz.mid";
+const char* FUZZ_SONG_PATH = "/fuzz-song.mid";
+
+void fail(const char* what, const size_t size) {
+  fprintf(stderr, "%s for an input of %zu bytes\n", what, size);
+  abort();
+}
+
+void parseWhole(const size_t size) {
+  midiFile song;
+  FsFile file;
+  file.open(FUZZ_PATH);
+  fileByteSource source(&file);
+  song.assignSource(&source);
+  song.parseMidi();
+
+  // every event read takes at least one byte, bar the one each track
+  // may have been cut off in, so our parse can't outgrow our input
+  const parseStats& stats = song.getStats();
+  if (stats.bytesRead > size) {
+    fail("parseMidi read more bytes than it was given", size);
+  }
+  if (stats.eventsRead > stats.bytesRead + song.trackProfiles.size()) {
+    fail("parseMidi read more events than bytes", size);
+  }
+  return;
+}
+
+void parseIncremental(void) {
+  midiFile song;
+  FsFile file;
+  file.open(FUZZ_PATH);
+  song.parseMidiIncremental(&file);
+  return;
+}
+
+// our cache is only read once its header matches its song's, so our song
+// is given the header our input claims, letting the rest of it be read
+void loadCache(const uint8_t* data, const size_t size) {
+  std::vector<uint8_t> header = { 'M', 'T', 'h', 'd', 0, 0, 0, HEADER_LEN };
+  for (size_t i = 0; i + 1 < std::min<size_t>(size, HEADER_LEN); i += 2) {
+    const uint16_t value = data[i] | (data[i + 1] << 8);
+    header.push_back(value >> 8);
+    header.push_back(value & 0xFF);
+  }
+  sdFiles()[FUZZ_SONG_PATH] = std::make_shared<std::vector<uint8_t>>(header);
+
+  midiFile song;
+  FsFile file, source;
+  file.open(FUZZ_PATH);
+  source.open(FUZZ_SONG_PATH);
+  song.loadEvents(file, source);
+  sdFiles().erase(FUZZ_SONG_PATH);
+  return;
+}
+
+std::vector<uint8_t> readFile(const std::string& path) {
+  std::ifstream input(path, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  sdFiles()[FUZZ_PATH] = std::make_shared<std::vector<uint8_t>>(data, data + size);
+  parseWhole(size);
+  parseIncremental();
+  loadCache(data, size);
+  sdFiles().erase(FUZZ_PATH);
+  return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+// the number of truncated and mutated copies replayed for each seed
+#define FUZZ_TRUNCATIONS 64
+#define FUZZ_MUTATIONS 256
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <seed corpus directory>\n", argv[0]);
+    return 2;
+  }
+  std::vector<std::string> seeds;
+  DIR* dir = opendir(argv[1]);
+  if (dir != nullptr) {
+    while (dirent* entry = readdir(dir)) {
+      if (entry->d_name[0] != '.') {
+        seeds.push_back(std::string(argv[1]) + "/" + entry->d_name);
+      }
+    }
+    closedir(dir);
+  }
+  if (seeds.empty()) {
+    fprintf(stderr, "no seeds found in %s\n", argv[1]);
+    return 1;
+  }
+  std::sort(seeds.begin(), seeds.end());
+
+  // a fixed seed keeps every run replaying the same inputs
+  uint32_t random = 0x2545F491;
+  auto next = [&random](void) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return random;
+  };
+
+  // our cache files are read back by loadEvents(), so each seed
+  // that parses is also replayed as the cache it would be saved as
+  std::vector<std::vector<uint8_t>> inputs;
+  for (const std::string& path : seeds) {
+    inputs.push_back(readFile(path));
+    sdFiles()[FUZZ_PATH] = std::make_shared<std::vector<uint8_t>>(inputs.back());
+    midiFile song;
+    FsFile file;
+    file.open(FUZZ_PATH);
+    fileByteSource source(&file);
+    song.assignSource(&source);
+    if (song.parseMidi()) {
+      FsFile cache;
+      cache.open("/fuzz.cache", O_RDWR | O_CREAT | O_TRUNC);
+      song.saveEvents(cache);
+      inputs.push_back(*sdFiles()["/fuzz.cache"]);
+      sdFiles().erase("/fuzz.cache");
+    }
+  }
+
+  // a division of 0 gives our ticks no length, so our first seed
+  // must be refused by both ways of parsing once its division is zeroed
+  std::vector<uint8_t> zeroDivision = readFile(seeds.front());
+  if (zeroDivision.size() >= 8 + HEADER_LEN) {
+    zeroDivision[12] = zeroDivision[13] = 0;
+    sdFiles()[FUZZ_PATH] = std::make_shared<std::vector<uint8_t>>(zeroDivision);
+    midiFile whole, incremental;
+    FsFile file, incrementalFile;
+    file.open(FUZZ_PATH);
+    incrementalFile.open(FUZZ_PATH);
+    fileByteSource source(&file);
+    whole.assignSource(&source);
+    if (whole.parseMidi() || incremental.parseMidiIncremental(&incrementalFile)) {
+      fail("a division of 0 was accepted", zeroDivision.size());
+    }
+    inputs.push_back(zeroDivision);
+  }
+
+  uint32_t replayed = 0;
+  for (const std::vector<uint8_t>& seed : inputs) {
+    LLVMFuzzerTestOneInput(seed.data(), seed.size());
+    replayed++;
+    for (uint32_t i = 0; i < FUZZ_TRUNCATIONS && !seed.empty(); i++) {
+      LLVMFuzzerTestOneInput(seed.data(), (seed.size() * i) / FUZZ_TRUNCATIONS);
+      replayed++;
+    }
+    for (uint32_t i = 0; i < FUZZ_MUTATIONS && !seed.empty(); i++) {
+      std::vector<uint8_t> mutated = seed;
+      const uint32_t changes = 1 + next() % 8;
+      for (uint32_t j = 0; j < changes; j++) {
+        const uint32_t at = next() % mutated.size();
+        switch (next() % 4) {
+          case 0:
+            mutated[at] = next();
+            break;
+          case 1:
+            mutated[at] |= 0x80;
+            break;
+          case 2:
+            mutated.insert(mutated.begin() + at, 1 + next() % 4, 0xFF);
+            break;
+          default:
+            mutated.erase(mutated.begin() + at, mutated.begin() + std::min<size_t>(at + 1 + next() % 4, mutated.size()));
+            break;
+        }
+        if (mutated.empty()) {
+          break;
+        }
+      }
+      LLVMFuzzerTestOneInput(mutated.data(), mutated.size());
+      replayed++;
+    }
+  }
+  printf("replayed %u inputs from %zu seeds\n", replayed, inputs.size());
+  return 0;
+}
+#endif
@@ -0,0 +1,83 @@
+#ifndef SHIM_ARDUINO_H
+#define SHIM_ARDUINO_H
+// just enough of the Arduino core for our firmware's sources to be built and tested on a host
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#include "freertos.h"
+
+typedef uint8_t byte;
+
+#define IRAM_ATTR
+#define PROGMEM
+#define HEX 16
+#define OUTPUT 1
+#define INPUT 0
+#define LOW 0
+#define HIGH 1
+#define SERIAL_8N1 0
+
+// our serial monitor, whose output is thrown away
+class Print {
+  public:
+  template <class T> size_t print(T, int = 0) { return 0; }
+  template <class T> size_t println(T, int = 0) { return 0; }
+  size_t println(void) { return 0; }
+  int available(void) { return 0; }
+  int read(void) { return -1; }
+  void begin(unsigned long, uint32_t = 0, int8_t = -1, int8_t = -1) {}
+  operator bool(void) { return true; }
+};
+
+// our UART, which keeps every byte written to it so that tests can inspect them
+// txFree stands in for the room left in our driver's transmit buffer
+// and is only given back by whichever test is draining it
+class HardwareSerial : public Print {
+  public:
+  std::vector<uint8_t> written;
+  size_t txFree = 0;
+
+  size_t write(const uint8_t* buffer, size_t size) {
+    this->written.insert(this->written.end(), buffer, buffer + size);
+    this->txFree -= std::min(this->txFree, size);
+    return size;
+  }
+  size_t write(uint8_t value) { return write(&value, 1); }
+  int availableForWrite(void) { return this->txFree; }
+  size_t setTxBufferSize(size_t size) {
+    this->txFree = size;
+    return size;
+  }
+  bool setRxFIFOFull(uint8_t) { return true; }
+  bool setRxTimeout(uint8_t) { return true; }
+  void onReceive(std::function<void(void)>, bool = true) {}
+};
+
+class EspClass {
+  public:
+  uint32_t getFreeHeap(void) { return 0; }
+  uint32_t getMinFreeHeap(void) { return 0; }
+  uint32_t getMaxAllocHeap(void) { return 0; }
+};
+
+extern Print Serial;
+extern HardwareSerial Serial1;
+extern EspClass ESP;
+
+// the time seen by our firmware in uS, which only moves when a test moves it
+extern int64_t shimMicros;
+
+unsigned long micros(void);
+unsigned long millis(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+uint32_t getCpuFrequencyMhz(void);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef SHIM_FASTACCELSTEPPER_H
+#define SHIM_FASTACCELSTEPPER_H
+// a stand in for our stepper library's engine, which hands out steppers
+// from the same two drivers our ESP32 has, and remembers the tones it was given
+#include "Arduino.h"
+
+#define SUPPORT_SELECT_DRIVER_TYPE
+#define DRIVER_MCPWM_PCNT 0
+#define DRIVER_RMT 1
+#define DRIVER_DONT_CARE 2
+
+#define TONE_OK 0
+#define TONE_ERR_FREQUENCY_TOO_HIGH -2
+
+class FastAccelStepperEngine;
+
+class FastAccelStepper {
+  public:
+  uint8_t pin = 0;
+  uint32_t toneMilliHz = 0;
+  bool autoEnable = false;
+
+  // tones above this are refused, as they would be by a real stepper
+  uint32_t maxMilliHz = UINT32_MAX;
+
+  void setAutoEnable(bool enable) { this->autoEnable = enable; }
+  int8_t setToneInMilliHz(uint32_t freq) {
+    if (freq > this->maxMilliHz) {
+      return TONE_ERR_FREQUENCY_TOO_HIGH;
+    }
+    this->toneMilliHz = freq;
+    return TONE_OK;
+  }
+  void stopTone(void) { this->toneMilliHz = 0; }
+  bool isToneActive(void) { return this->toneMilliHz != 0; }
+  bool isQueueRunning(void) { return this->toneMilliHz != 0; }
+};
+
+class FastAccelStepperEngine {
+  // the steppers each of our drivers has handed out
+  std::vector<FastAccelStepper> steppers[2];
+
+  public:
+  // a single call to stepperConnectToPin(), in the order they were made
+  struct connection {
+    uint8_t pin;
+    uint8_t driver;
+    bool connected;
+  };
+  std::vector<connection> connections;
+
+  // the number of steppers each of our drivers can hand out
+  uint8_t capacity[2] = { 6, 8 };
+
+  void init(uint8_t) {}
+  FastAccelStepper* stepperConnectToPin(uint8_t pin, uint8_t driver = DRIVER_DONT_CARE) {
+    if (driver == DRIVER_DONT_CARE) {
+      driver = (this->steppers[DRIVER_MCPWM_PCNT].size() < this->capacity[DRIVER_MCPWM_PCNT]) ? DRIVER_MCPWM_PCNT : DRIVER_RMT;
+    }
+    const bool connected = this->steppers[driver].size() < this->capacity[driver];
+    this->connections.push_back({ pin, driver, connected });
+    if (!connected) {
+      return NULL;
+    }
+
+    // our steppers are never moved once handed out
+    this->steppers[driver].reserve(this->capacity[driver]);
+    this->steppers[driver].emplace_back();
+    this->steppers[driver].back().pin = pin;
+    return &this->steppers[driver].back();
+  }
+  void setToneStartCallback(void (*)(FastAccelStepper*)) {}
+  void beginToneBatch(void) {}
+  void commitToneBatch(void) {}
+  uint32_t getMaxToneStartSkewInCycles(void) { return 0; }
+  void resetMaxToneStartSkew(void) {}
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef SHIM_SDFAT_H
+#define SHIM_SDFAT_H
+// our SD card is kept in memory on our host, as a map from each path to its contents
+#include "Arduino.h"
+#include <map>
+#include <memory>
+
+#define O_RDONLY 0x00
+#define O_WRONLY 0x01
+#define O_RDWR 0x02
+#define O_AT_END 0x04
+#define O_CREAT 0x10
+#define O_EXCL 0x20
+#define O_TRUNC 0x40
+#define FS_ATTRIB_HIDDEN 0x02
+#define SHARED_SPI 0
+#define SD_SCK_MHZ(mhz) (mhz)
+
+class SdSpiConfig {
+  public:
+  SdSpiConfig(int, int, int) {}
+};
+
+// every file on our card, by path
+std::map<std::string, std::shared_ptr<std::vector<uint8_t>>>& sdFiles(void);
+
+class FsFile {
+  std::shared_ptr<std::vector<uint8_t>> data;
+  uint64_t position = 0;
+
+  public:
+  bool open(const char* path, int flags = O_RDONLY);
+  bool open(FsFile*, const char* path, int flags = O_RDONLY) { return open(path, flags); }
+  bool openNext(FsFile*, int = O_RDONLY) { return false; }
+  bool close(void) {
+    this->data.reset();
+    return true;
+  }
+  bool isOpen(void) const { return this->data != nullptr; }
+  operator bool(void) const { return isOpen(); }
+
+  int read(void* buffer, size_t size);
+  int read(void);
+  int peek(void);
+  size_t write(const void* buffer, size_t size);
+  size_t write(uint8_t value) { return write(&value, 1); }
+  bool seekSet(uint64_t position);
+  bool seekCur(int64_t offset) { return seekSet(this->position + offset); }
+  uint64_t curPosition(void) const { return this->position; }
+  uint64_t fileSize(void) const { return this->data ? this->data->size() : 0; }
+  bool truncate(void);
+  bool preAllocate(uint64_t) { return true; }
+  bool sync(void) { return true; }
+  bool getModifyDateTime(uint16_t* date, uint16_t* time) {
+    *date = 1;
+    *time = 1;
+    return true;
+  }
+  size_t getName(char* name, size_t) {
+    *name = 0;
+    return 0;
+  }
+  bool isDirectory(void) const { return false; }
+  bool isHidden(void) const { return false; }
+  bool attrib(uint8_t) { return true; }
+};
+
+class SdFs {
+  public:
+  bool begin(SdSpiConfig) { return true; }
+  void end(void) {}
+  bool exists(const char* path) { return sdFiles().count(path) != 0; }
+  bool remove(const char* path) { return sdFiles().erase(path) != 0; }
+  bool mkdir(const char*) { return true; }
+};
+
+#endif
@@ -0,0 +1,166 @@
+#include "Arduino.h"
+#include "SdFat.h"
+#include <esp_timer.h>
+
+Print Serial;
+HardwareSerial Serial1;
+EspClass ESP;
+int64_t shimMicros = 0;
+
+unsigned long micros(void) {
+  return shimMicros;
+}
+
+unsigned long millis(void) {
+  return shimMicros / 1000;
+}
+
+void delay(uint32_t ms) {
+  shimMicros += (int64_t)ms * 1000;
+}
+
+void delayMicroseconds(uint32_t us) {
+  shimMicros += us;
+}
+
+uint32_t getCpuFrequencyMhz(void) {
+  return 240;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+
+BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+  *handle = NULL;
+  return pdFAIL;
+}
+
+void vTaskDelete(TaskHandle_t) {}
+void vTaskDelay(TickType_t ticks) {
+  delay(ticks);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) {
+  return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t) {
+  return pdPASS;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t, uint32_t, eNotifyAction) {
+  return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t, uint32_t, uint32_t* value, TickType_t) {
+  *value = 0;
+  return pdFAIL;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+  static int mutex;
+  return &mutex;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t, TickType_t) {
+  return pdPASS;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t) {
+  return pdPASS;
+}
+
+int64_t esp_timer_get_time(void) {
+  return shimMicros;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t*, esp_timer_handle_t* handle) {
+  static int timer;
+  *handle = reinterpret_cast<esp_timer_handle_t>(&timer);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t, uint64_t) {
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t, uint64_t) {
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t) {
+  return ESP_OK;
+}
+
+std::map<std::string, std::shared_ptr<std::vector<uint8_t>>>& sdFiles(void) {
+  static std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> files;
+  return files;
+}
+
+bool FsFile::open(const char* path, int flags) {
+  auto found = sdFiles().find(path);
+  if (found == sdFiles().end()) {
+    if (!(flags & O_CREAT)) {
+      return false;
+    }
+    found = sdFiles().emplace(path, std::make_shared<std::vector<uint8_t>>()).first;
+  }
+  else if ((flags & O_CREAT) && (flags & O_EXCL)) {
+    return false;
+  }
+  this->data = found->second;
+  if (flags & O_TRUNC) {
+    this->data->clear();
+  }
+  this->position = (flags & O_AT_END) ? this->data->size() : 0;
+  return true;
+}
+
+int FsFile::read(void* buffer, size_t size) {
+  if (!this->data) {
+    return -1;
+  }
+  const size_t count = std::min<uint64_t>(size, this->data->size() - std::min<uint64_t>(this->position, this->data->size()));
+  if (count > 0) {
+    memcpy(buffer, this->data->data() + this->position, count);
+    this->position += count;
+  }
+  return count;
+}
+
+int FsFile::read(void) {
+  uint8_t value = 0;
+  return (read(&value, 1) == 1) ? value : -1;
+}
+
+int FsFile::peek(void) {
+  return (this->data && this->position < this->data->size()) ? (*this->data)[this->position] : -1;
+}
+
+size_t FsFile::write(const void* buffer, size_t size) {
+  if (!this->data || size == 0) {
+    return 0;
+  }
+  if (this->data->size() < this->position + size) {
+    this->data->resize(this->position + size);
+  }
+  memcpy(this->data->data() + this->position, buffer, size);
+  this->position += size;
+  return size;
+}
+
+bool FsFile::seekSet(uint64_t position) {
+  if (!this->data || position > this->data->size()) {
+    return false;
+  }
+  this->position = position;
+  return true;
+}
+
+bool FsFile::truncate(void) {
+  if (!this->data) {
+    return false;
+  }
+  this->data->resize(this->position);
+  return true;
+}
@@ -0,0 +1,64 @@
+// parses our duration fixtures and checks the length of each song, in uS,
+// against the length worked out by hand from its division and tempos
+// covering metrical timing through several tempo changes, delta times
+// too long for a single playback event, and every SMPTE frame rate
+// our SMPTE fixtures each hold tempo changes, which must have no effect
+#include "midi.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace {
+struct durationCase {
+  const char* name;
+  uint64_t length;
+};
+
+const durationCase cases[] = {
+  // 480 ticks per quarter note, 960 ticks at 500000, 960 at 250000 and 480 at 1000000
+  { "duration-ppq480-tempos.mid", 1000000 + 500000 + 1000000 },
+  // 96 ticks per quarter note at 500000, with 0x1000005 ticks between events
+  { "duration-ppq96-long-rest.mid", 2ULL * 0x1000005 * 500000 / 96 },
+  // 24 frames per second of 4 ticks, 288 ticks
+  { "duration-smpte24.mid", 3000000 },
+  // 25 frames per second of 40 ticks, 2500 ticks
+  { "duration-smpte25.mid", 2500000 },
+  // 30 drop frame, 30000 / 1001 frames per second of 80 ticks, 144000 ticks
+  { "duration-smpte29.mid", 60060000 },
+  // 30 frames per second of 100 ticks, 9000 ticks
+  { "duration-smpte30.mid", 3000000 },
+};
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <corpus directory>\n", argv[0]);
+    return 2;
+  }
+  int failed = 0;
+  for (const durationCase& test : cases) {
+    const std::string path = std::string(argv[1]) + "/" + test.name;
+    std::ifstream input(path, std::ios::binary);
+    sdFiles()[path] = std::make_shared<std::vector<uint8_t>>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+    midiFile song;
+    FsFile file;
+    file.open(path.c_str());
+    fileByteSource source(&file);
+    song.assignSource(&source);
+    if (!song.parseMidi()) {
+      fprintf(stderr, "%s: failed to parse\n", test.name);
+      failed++;
+      continue;
+    }
+    const uint64_t length = song.getStats().songLength;
+    if (length != test.length) {
+      fprintf(stderr, "%s: %llu uS, expected %llu uS\n", test.name, (unsigned long long)length, (unsigned long long)test.length);
+      failed++;
+    }
+  }
+  if (failed == 0) {
+    printf("%zu durations passed\n", sizeof(cases) / sizeof(cases[0]));
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,65 @@
+// replays byte streams through our live midi parser and checks the messages
+// it hands back, covering running status, realtime bytes part way through
+// other messages, system exclusive, system common and stray data bytes
+#include "uart-midiParser.hpp"
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+namespace {
+struct replayCase {
+  const char* name;
+  std::vector<uint8_t> bytes;
+  std::vector<std::vector<uint8_t>> expected;
+};
+
+const std::vector<replayCase> cases = {
+  { "note on", { 0x90, 0x3C, 0x64 }, { { 0x90, 0x3C, 0x64 } } },
+  { "running status", { 0x90, 0x3C, 0x64, 0x3E, 0x64, 0x3C, 0x00 }, { { 0x90, 0x3C, 0x64 }, { 0x90, 0x3E, 0x64 }, { 0x90, 0x3C, 0x00 } } },
+  { "single data byte messages", { 0xC5, 0x10, 0x11, 0xD2, 0x40 }, { { 0xC5, 0x10, 0x00 }, { 0xC5, 0x11, 0x00 }, { 0xD2, 0x40, 0x00 } } },
+  { "realtime part way through a message", { 0x90, 0xF8, 0x3C, 0xFA, 0x64 }, { { 0xF8, 0x00, 0x00 }, { 0xFA, 0x00, 0x00 }, { 0x90, 0x3C, 0x64 } } },
+  { "realtime under running status", { 0xB0, 0x07, 0x64, 0x07, 0xFE, 0x50 }, { { 0xB0, 0x07, 0x64 }, { 0xFE, 0x00, 0x00 }, { 0xB0, 0x07, 0x50 } } },
+  { "undefined realtime dropped", { 0x90, 0x3C, 0xF9, 0x64, 0xFD }, { { 0x90, 0x3C, 0x64 } } },
+  { "sysex skipped", { 0xF0, 0x7E, 0x7F, 0x09, 0x01, 0xF7, 0x90, 0x3C, 0x64 }, { { 0x90, 0x3C, 0x64 } } },
+  { "realtime within sysex", { 0xF0, 0x01, 0xF8, 0x02, 0xF7 }, { { 0xF8, 0x00, 0x00 } } },
+  { "sysex cancels running status", { 0x90, 0x3C, 0x64, 0xF0, 0x01, 0x02, 0xF7, 0x3E, 0x64 }, { { 0x90, 0x3C, 0x64 } } },
+  { "sysex ended by another status", { 0xF0, 0x01, 0x02, 0x80, 0x3C, 0x40 }, { { 0x80, 0x3C, 0x40 } } },
+  { "stray data bytes ignored", { 0x3C, 0x64, 0x90, 0x3C, 0x64 }, { { 0x90, 0x3C, 0x64 } } },
+  { "status interrupts a message", { 0x90, 0x3C, 0x80, 0x3C, 0x40 }, { { 0x80, 0x3C, 0x40 } } },
+  { "time code", { 0xF1, 0x23 }, { { 0xF1, 0x23, 0x00 } } },
+  { "song position", { 0xF2, 0x10, 0x20 }, { { 0xF2, 0x10, 0x20 } } },
+  { "song select", { 0xF3, 0x05 }, { { 0xF3, 0x05, 0x00 } } },
+  { "tune request", { 0xF6 }, { { 0xF6, 0x00, 0x00 } } },
+  { "system common cancels running status", { 0x90, 0x3C, 0x64, 0xF1, 0x23, 0x3E, 0x64, 0xF3, 0x01, 0x02 }, { { 0x90, 0x3C, 0x64 }, { 0xF1, 0x23, 0x00 }, { 0xF3, 0x01, 0x00 } } },
+  { "undefined system common ignored", { 0xF4, 0x01, 0xF5, 0x90, 0x3C, 0x64 }, { { 0x90, 0x3C, 0x64 } } },
+};
+
+std::vector<std::vector<uint8_t>> replay(midiParser& parser, const std::vector<uint8_t>& bytes) {
+  std::vector<std::vector<uint8_t>> messages;
+  for (const uint8_t byte : bytes) {
+    liveMessage message = { 0, 0, 0, 0 };
+    if (parser.parse(byte, message)) {
+      messages.push_back({ message.status, message.data1, message.data2 });
+    }
+  }
+  return messages;
+}
+}
+
+int main(void) {
+  for (const replayCase& test : cases) {
+    midiParser parser;
+    if (replay(parser, test.bytes) != test.expected) {
+      fprintf(stderr, "failed: %s\n", test.name);
+      return 1;
+    }
+  }
+
+  // a message left part way through is forgotten along with our running status
+  midiParser parser;
+  assert(replay(parser, { 0x90, 0x3C }).empty());
+  parser.reset();
+  assert(replay(parser, { 0x64, 0x3C, 0x64 }).empty());
+  printf("%zu replays passed\n", cases.size() + 1);
+  return 0;
+}
@@ -0,0 +1,60 @@
+// checks the frequencies our modulation engine gives our steppers
+// every note must match our note table, and a bend sweeping across
+// the top of our range must rise smoothly, staying within our range,
+// with a single drop of exactly one octave where it is folded
+#include "midi-noteTable.hpp"
+#include "stepper-modulation.hpp"
+#include <cmath>
+#include <cstdio>
+
+int main(void) {
+  modulationEngine modulation;
+  int failed = 0;
+
+  // each octave a note is folded by may cost up to 1 mHz of rounding
+  for (uint8_t note = 0; note < MIDI_NOTE_COUNT; note++) {
+    const uint32_t freq = modulation.noteOn(0, 0, note, false);
+    if (std::abs((int64_t)freq - midi::freqTable()[note]) > 2) {
+      fprintf(stderr, "note %u plays at %u mHz, expected %u mHz\n", note, freq, midi::freqTable()[note]);
+      failed++;
+    }
+  }
+
+  // bend a note a whole tone beneath our highest up by a whole tone
+  // passing through our highest note and on to the note above it
+  modulation.reset();
+  uint32_t last = modulation.noteOn(0, 0, MIDI_NOTE_HIGHEST - 1, false);
+  uint8_t folds = 0;
+  for (uint16_t bend = PITCH_BEND_CENTER; bend <= 0x3FFF; bend += 16) {
+    modulation.pitchBend(0, bend);
+    modulation.update(1);
+    const uint32_t freq = modulation.getFreq(0);
+    if (freq < midi::rangeFloor || freq >= midi::rangeCeiling) {
+      fprintf(stderr, "bend %u plays at %u mHz, outside of our range\n", bend, freq);
+      failed++;
+    }
+
+    // 16 steps of our wheel move us less than one cent, or an octave less one cent once folded
+    const double ratio = (double)freq / last;
+    if (ratio < 0.5) {
+      fprintf(stderr, "bend %u dropped from %u mHz to %u mHz\n", bend, last, freq);
+      failed++;
+    }
+    else if (ratio < 0.51) {
+      folds++;
+    }
+    else if (ratio < 1.0 || ratio > 1.001) {
+      fprintf(stderr, "bend %u jumped from %u mHz to %u mHz\n", bend, last, freq);
+      failed++;
+    }
+    last = freq;
+  }
+  if (folds != 1) {
+    fprintf(stderr, "our bend was folded %u times, expected once\n", folds);
+    failed++;
+  }
+  if (failed == 0) {
+    printf("modulation frequencies passed\n");
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,47 @@
+// checks every entry of our note table against the analytic equal tempered
+// frequency of the note it is folded to, and that folding only ever moves
+// a note by whole octaves, the fewest needed to bring it within our range
+// then checks our cent multipliers against the analytic ratio of each cent
+#include "midi-noteTable.hpp"
+#include <cmath>
+#include <cstdio>
+
+int main(void) {
+  const std::array<uint32_t, MIDI_NOTE_COUNT>& table = midi::freqTable();
+  int failed = 0;
+  for (int note = 0; note < MIDI_NOTE_COUNT; note++) {
+    int folded = note;
+    while (folded > MIDI_NOTE_HIGHEST) {
+      folded -= 12;
+    }
+    while (folded < MIDI_NOTE_LOWEST) {
+      folded += 12;
+    }
+    if (midi::foldNote(note) != folded) {
+      fprintf(stderr, "note %d folds to %u, expected %d\n", note, midi::foldNote(note), folded);
+      failed++;
+    }
+
+    // our table rounds to the nearest mHz, so half a mHz is all it may be out by
+    // along with a little for the error our compile time powers build up
+    const long double analytic = MIDI_CONCERT_PITCH * std::pow(2.0L, (folded - MIDI_CONCERT_NOTE) / 12.0L);
+    if (std::fabs(table[note] - analytic) > 0.501L) {
+      fprintf(stderr, "note %d is %u mHz, expected %.3Lf mHz\n", note, table[note], analytic);
+      failed++;
+    }
+  }
+
+  // our cent multipliers are 16.16 fixed point, rounded to the nearest step
+  const std::array<uint32_t, 101>& cents = midi::centTable();
+  for (int cent = 0; cent <= 100; cent++) {
+    const long double analytic = 65536.0L * std::pow(2.0L, cent / 1200.0L);
+    if (std::fabs(cents[cent] - analytic) > 0.501L) {
+      fprintf(stderr, "cent %d is %u, expected %.3Lf\n", cent, cents[cent], analytic);
+      failed++;
+    }
+  }
+  if (failed == 0) {
+    printf("%d note frequencies and 101 cent multipliers passed\n", MIDI_NOTE_COUNT);
+  }
+  return failed ? 1 : 0;
+}
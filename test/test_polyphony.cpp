@@ -0,0 +1,71 @@
+// parses our polyphony fixtures and checks how each track was profiled
+// a track of chords overlaps for most of every note and must be polyphonic
+// while a legato melody, whose notes only brush past one another, must not be
+// no matter how many of its brief overlaps add up over the length of the song
+// and with no steppers available, every policy must drop a note rather than steal
+#include "midi.hpp"
+#include "stepper-voiceManager.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace {
+struct polyphonyCase {
+  const char* name;
+  uint32_t noteCount;
+  uint8_t maxVoices;
+  bool polyphonic;
+};
+
+const polyphonyCase cases[] = {
+  // eight three note chords, each a quarter note long
+  { "polyphony-chords.mid", 24, 3, true },
+  // 64 quarter notes, each held 25mS into the next
+  { "polyphony-legato.mid", 64, 2, false },
+};
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <corpus directory>\n", argv[0]);
+    return 2;
+  }
+  int failed = 0;
+  for (const polyphonyCase& test : cases) {
+    const std::string path = std::string(argv[1]) + "/" + test.name;
+    std::ifstream input(path, std::ios::binary);
+    sdFiles()[path] = std::make_shared<std::vector<uint8_t>>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+    midiFile song;
+    FsFile file;
+    file.open(path.c_str());
+    fileByteSource source(&file);
+    song.assignSource(&source);
+    if (!song.parseMidi() || song.trackProfiles.size() != 1) {
+      fprintf(stderr, "%s: failed to parse\n", test.name);
+      failed++;
+      continue;
+    }
+    const trackProfile& profile = song.trackProfiles[0];
+    if (profile.noteCount != test.noteCount || profile.maxVoices != test.maxVoices || profile.polyphonic != test.polyphonic) {
+      fprintf(stderr, "%s: %u notes, %u voices, polyphonic %d, expected %u notes, %u voices, polyphonic %d\n", test.name, profile.noteCount, profile.maxVoices, profile.polyphonic, test.noteCount, test.maxVoices, test.polyphonic);
+      failed++;
+    }
+  }
+
+  // this runs under our sanitizers, which catch any policy
+  // that looks for a victim among steppers that aren't there
+  for (uint8_t policy = 0; policy < VOICE_STEAL_POLICIES; policy++) {
+    voiceManager voices;
+    voices.setAvailable(0);
+    voices.setPolicy(policy);
+    if (voices.noteOn(0, 60, 100, true) != NOT_FOUND || voices.getDrops()[policy] != 1) {
+      fprintf(stderr, "policy %u: note wasn't dropped with no steppers available\n", policy);
+      failed++;
+    }
+  }
+  if (failed == 0) {
+    printf("%zu polyphony profiles passed\n", sizeof(cases) / sizeof(cases[0]));
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,60 @@
+// saves a parsed song to its cache and checks that the cache is only trusted
+// while it still describes the song's header. our shim's files all share
+// one modification time, so a song rewritten at the same size can only be
+// told apart by its header, and an out of date cache must be removed
+// with our song left at its start, ready to be parsed
+#include "midi.hpp"
+#include "sdio.hpp"
+#include "sdio-songCache.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <corpus directory>\n", argv[0]);
+    return 2;
+  }
+  const std::string songPath = "/format1-4tracks.mid";
+  std::ifstream input(std::string(argv[1]) + songPath, std::ios::binary);
+  sdFiles()[songPath] = std::make_shared<std::vector<uint8_t>>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+  const std::string cachePath = songCachePath(songPath);
+  int failed = 0;
+
+  FsFile song;
+  song.open(songPath.c_str());
+  fileByteSource source(&song);
+  songData.assignSource(&source);
+  if (!songData.parseMidi() || !saveSongCache(song, songPath)) {
+    fprintf(stderr, "failed to parse and cache our song\n");
+    return 1;
+  }
+
+  // an unchanged song loads from its cache
+  if (!loadSongCache(song, songPath)) {
+    fprintf(stderr, "unchanged song wasn't loaded from its cache\n");
+    failed++;
+  }
+
+  // the same song with one track fewer and a new division is the same size
+  std::vector<uint8_t>& bytes = *sdFiles()[songPath];
+  bytes[11]--;
+  bytes[13] ^= 0x01;
+  song.seekSet(5);
+  if (loadSongCache(song, songPath)) {
+    fprintf(stderr, "cache was loaded for a song whose header changed\n");
+    failed++;
+  }
+  if (sd.exists(cachePath.c_str())) {
+    fprintf(stderr, "out of date cache was left behind\n");
+    failed++;
+  }
+  if (song.curPosition() != 0) {
+    fprintf(stderr, "song was left at %llu rather than its start\n", (unsigned long long)song.curPosition());
+    failed++;
+  }
+  if (failed == 0) {
+    printf("song cache checks passed\n");
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,124 @@
+// checks that our steppers are handed out by our MCPWM/PCNT driver first
+// and by our RMT driver once it runs out, each on its own pin of MTR_STEPS,
+// and that a stepper no driver could connect is never given a note
+// nor is a stepper kept for a note whose tone it refused
+#include "FastAccelStepper.h"
+#include "midi.hpp"
+#include "stepper.hpp"
+#include <cassert>
+#include <cstdio>
+
+extern FastAccelStepperEngine engine;
+extern std::array<FastAccelStepper*, STEPPER_CHANNELS> stepper;
+
+namespace {
+const uint8_t pins[] = { MTR_STEPS };
+
+// connects our steppers to an engine whose drivers can hand out
+// mcpwmPcnt and rmt steppers, returning the driver each stepper was given
+std::array<uint8_t, STEPPER_CHANNELS> connectWith(const uint8_t mcpwmPcnt, const uint8_t rmt) {
+  engine = FastAccelStepperEngine();
+  engine.capacity[DRIVER_MCPWM_PCNT] = mcpwmPcnt;
+  engine.capacity[DRIVER_RMT] = rmt;
+  initializeStepper();
+  std::array<uint8_t, STEPPER_CHANNELS> drivers;
+  for (uint8_t i = 0; i < STEPPER_CHANNELS; i++) {
+    drivers[i] = getStepperDriver(i);
+    assert((stepper[i] == NULL) == (drivers[i] == STEPPER_DRIVER_NONE));
+    assert(stepper[i] == NULL || stepper[i]->pin == pins[i]);
+    assert(stepper[i] == NULL || stepper[i]->autoEnable);
+  }
+  return drivers;
+}
+
+void testEveryStepperOnMcpwmPcnt(void) {
+  const auto drivers = connectWith(6, 8);
+  assert(engine.connections.size() == STEPPER_CHANNELS);
+  for (uint8_t i = 0; i < STEPPER_CHANNELS; i++) {
+    assert(drivers[i] == STEPPER_DRIVER_MCPWM_PCNT);
+    assert(engine.connections[i].pin == pins[i]);
+    assert(engine.connections[i].driver == DRIVER_MCPWM_PCNT);
+  }
+  return;
+}
+
+void testFallbackToRmt(void) {
+  // our first two steppers exhaust our MCPWM/PCNT driver, so each stepper after them
+  // asks it first, is refused, then is handed out by our RMT driver
+  const auto drivers = connectWith(2, 8);
+  const FastAccelStepperEngine::connection expected[] = {
+    { pins[0], DRIVER_MCPWM_PCNT, true },
+    { pins[1], DRIVER_MCPWM_PCNT, true },
+    { pins[2], DRIVER_MCPWM_PCNT, false },
+    { pins[2], DRIVER_RMT, true },
+    { pins[3], DRIVER_MCPWM_PCNT, false },
+    { pins[3], DRIVER_RMT, true },
+  };
+  assert(engine.connections.size() == sizeof(expected) / sizeof(expected[0]));
+  for (uint8_t i = 0; i < engine.connections.size(); i++) {
+    assert(engine.connections[i].pin == expected[i].pin);
+    assert(engine.connections[i].driver == expected[i].driver);
+    assert(engine.connections[i].connected == expected[i].connected);
+  }
+  assert(drivers[0] == STEPPER_DRIVER_MCPWM_PCNT && drivers[1] == STEPPER_DRIVER_MCPWM_PCNT);
+  assert(drivers[2] == STEPPER_DRIVER_RMT && drivers[3] == STEPPER_DRIVER_RMT);
+  return;
+}
+
+void testUnconnectedStepperLeftOut(void) {
+  // our drivers only have three steppers between them, so our last is left out
+  const auto drivers = connectWith(2, 1);
+  assert(drivers[0] == STEPPER_DRIVER_MCPWM_PCNT && drivers[1] == STEPPER_DRIVER_MCPWM_PCNT);
+  assert(drivers[2] == STEPPER_DRIVER_RMT);
+  assert(drivers[3] == STEPPER_DRIVER_NONE);
+  assert(getStepperDriver(STEPPER_CHANNELS) == STEPPER_DRIVER_NONE);
+
+  // more notes than we have steppers must never reach our missing stepper
+  for (uint8_t channel = 0; channel < 8; channel++) {
+    const uint8_t played = playNote(60 + channel, 100, MIDI_NOTE_ON | channel, true);
+    assert(played == NOT_FOUND || played < 3);
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    assert(stepper[i]->isToneActive());
+  }
+  silenceSteppers();
+  for (uint8_t i = 0; i < 3; i++) {
+    assert(!stepper[i]->isToneActive());
+  }
+  return;
+}
+
+void testRefusedToneFreesStepper(void) {
+  connectWith(6, 8);
+  resetControllers();
+
+  // a note our stepper refuses to play never holds on to it
+  stepper[0]->maxMilliHz = 0;
+  assert(playNote(60, 100, MIDI_NOTE_ON, true) == NOT_FOUND);
+  assert(!stepper[0]->isToneActive());
+  stepper[0]->maxMilliHz = UINT32_MAX;
+  assert(playNote(62, 100, MIDI_NOTE_ON, true) == 0);
+  assert(stepper[0]->isToneActive());
+
+  // nor does a note bent beyond what our stepper can play
+  stepper[0]->maxMilliHz = stepper[0]->toneMilliHz;
+  pitchBend(0, 0x3FFF);
+  updateModulation();
+  assert(!stepper[0]->isToneActive());
+  assert(playNote(62, 0, MIDI_NOTE_OFF, true) == NOT_FOUND);
+  stepper[0]->maxMilliHz = UINT32_MAX;
+  assert(playNote(64, 100, MIDI_NOTE_ON, true) == 0);
+  silenceSteppers();
+  resetControllers();
+  return;
+}
+}
+
+int main(void) {
+  testEveryStepperOnMcpwmPcnt();
+  testFallbackToRmt();
+  testUnconnectedStepperLeftOut();
+  testRefusedToneFreesStepper();
+  printf("stepper driver allocation passed\n");
+  return 0;
+}
@@ -0,0 +1,121 @@
+// checks the bytes our thru sends for running status, realtime and system common
+// messages, then floods our thru far faster than our wire can carry while
+// draining our transmit buffer at our baud rate, checking that every message
+// that makes it out is whole and that the rest are dropped rather than queued
+#include "uart-thru.hpp"
+#include "uart-midiParser.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+namespace {
+struct thruCase {
+  const char* name;
+  std::vector<std::vector<uint8_t>> messages;
+  std::vector<uint8_t> expected;
+};
+
+const std::vector<thruCase> cases = {
+  { "running status", { { 0x90, 0x3C, 0x64 }, { 0x90, 0x3E, 0x64 } }, { 0x90, 0x3C, 0x64, 0x3E, 0x64 } },
+  { "note off as note on", { { 0x90, 0x3C, 0x64 }, { 0x80, 0x3C, 0x40 } }, { 0x90, 0x3C, 0x64, 0x3C, 0x00 } },
+  { "single data byte messages", { { 0xC5, 0x10, 0x00 }, { 0xC5, 0x11, 0x00 } }, { 0xC5, 0x10, 0x11 } },
+  { "realtime keeps running status", { { 0x90, 0x3C, 0x64 }, { 0xF8, 0x00, 0x00 }, { 0x90, 0x3E, 0x64 } }, { 0x90, 0x3C, 0x64, 0xF8, 0x3E, 0x64 } },
+  { "time code", { { 0xF1, 0x23, 0x00 } }, { 0xF1, 0x23 } },
+  { "song position", { { 0xF2, 0x10, 0x20 } }, { 0xF2, 0x10, 0x20 } },
+  { "song select", { { 0xF3, 0x05, 0x00 } }, { 0xF3, 0x05 } },
+  { "tune request", { { 0xF6, 0x00, 0x00 } }, { 0xF6 } },
+  { "system common cancels running status", { { 0x90, 0x3C, 0x64 }, { 0xF3, 0x05, 0x00 }, { 0x90, 0x3E, 0x64 } }, { 0x90, 0x3C, 0x64, 0xF3, 0x05, 0x90, 0x3E, 0x64 } },
+  { "system exclusive never sent", { { 0xF0, 0x00, 0x00 }, { 0xF7, 0x00, 0x00 } }, {} },
+};
+
+// each case starts on an idle wire, so its first message sends its status
+void idle(void) {
+  shimMicros += UART_THRU_STATUS_REFRESH + 1;
+  Serial1.written.clear();
+  Serial1.txFree = UART_THRU_BUFFER;
+  return;
+}
+
+// sends a chord of eight notes every mS, with a clock between each, for a second
+// giving our wire back the bytes it would have carried in each mS
+bool flood(void) {
+  std::vector<std::vector<uint8_t>> sent;
+  uint64_t drained = 0;
+  for (uint32_t ms = 0; ms < 1000; ms++) {
+    for (uint8_t note = 0; note < 8; note++) {
+      const uint8_t status = (ms & 1) ? 0x80 : 0x90;
+      sendThru(status, 0x30 + note, 0x64);
+      sent.push_back({ 0x90, (uint8_t)(0x30 + note), (uint8_t)((ms & 1) ? 0x00 : 0x64) });
+    }
+    sendThru(0xF8, 0, 0);
+    sent.push_back({ 0xF8, 0x00, 0x00 });
+    shimMicros += 1000;
+
+    // our wire carries UART_THRU_BYTES_PER_SECOND, give or take a byte each mS
+    const uint64_t carried = ((uint64_t)(ms + 1) * UART_THRU_BYTES_PER_SECOND) / 1000;
+    Serial1.txFree = std::min<size_t>(Serial1.txFree + (carried - drained), UART_THRU_BUFFER);
+    drained = carried;
+  }
+
+  // nothing more can have been written than our buffer and our wire could hold
+  if (Serial1.written.size() > UART_THRU_BUFFER + UART_THRU_BYTES_PER_SECOND) {
+    fprintf(stderr, "flood: %zu bytes written to a wire that carries %d\n", Serial1.written.size(), UART_THRU_BYTES_PER_SECOND);
+    return false;
+  }
+
+  // every message on our wire must be one we sent, whole and in order
+  midiParser parser;
+  size_t next = 0;
+  size_t received = 0;
+  for (const uint8_t byte : Serial1.written) {
+    liveMessage message = { 0, 0, 0, 0 };
+    if (!parser.parse(byte, message)) {
+      continue;
+    }
+    const std::vector<uint8_t> bytes = { message.status, message.data1, message.data2 };
+    while (next < sent.size() && sent[next] != bytes) {
+      next++;
+    }
+    if (next == sent.size()) {
+      fprintf(stderr, "flood: message %zu on our wire was never sent whole\n", received);
+      return false;
+    }
+    next++;
+    received++;
+  }
+  if (received == 0 || received == sent.size()) {
+    fprintf(stderr, "flood: %zu of %zu messages sent, expected some to be dropped\n", received, sent.size());
+    return false;
+  }
+  return true;
+}
+}
+
+int main(void) {
+  initializeThru();
+  assert(Serial1.txFree == UART_THRU_BUFFER);
+  for (const thruCase& test : cases) {
+    idle();
+    for (const std::vector<uint8_t>& message : test.messages) {
+      sendThru(message[0], message[1], message[2]);
+    }
+    if (Serial1.written != test.expected) {
+      fprintf(stderr, "failed: %s\n", test.name);
+      return 1;
+    }
+  }
+
+  // a message that won't fit whole is dropped, and sends nothing at all
+  idle();
+  Serial1.txFree = 2;
+  sendThru(0x90, 0x3C, 0x64);
+  assert(Serial1.written.empty());
+
+  idle();
+  if (!flood()) {
+    return 1;
+  }
+  printf("%zu thru cases and our flood passed\n", cases.size());
+  return 0;
+}